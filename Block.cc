@@ -46,4 +46,8 @@ void Block::save(STREAM &output) {
     write32(output, lastWriteTime);
 }
 
+void Block::updateLastWriteTime() {
+    lastWriteTime = now();
+}
+
 } // SDI4FS
@@ -57,6 +57,12 @@ public:
      * @param output the stream to write into
      */
     virtual void save(STREAM &output);
+protected:
+    /**
+     * Sets the last write time to now, without writing anything.
+     * Used by blocks whose header is not stored in the block itself (see DataBlock).
+     */
+    void updateLastWriteTime();
 private:
     /**
      * Unique id of this block.
@@ -14,21 +14,30 @@
 
 namespace SDI4FS {
 
-DataBlock::DataBlock(STREAM &input) : Block(input), dirty(false) {
+DataBlock::DataBlock(STREAM &input) : Block(input), dirty(false), size_b(SDI4FS_MAX_BYTES_PER_DATABLOCK) {
     // read stored content
-    readN(input, &data[0], SDI4FS_MAX_BYTES_PER_DATABLOCK);
+    readN(input, &data[0], size_b);
 }
 
-DataBlock::DataBlock(uint32_t id) : Block(id), dirty(false) {
+DataBlock::DataBlock(STREAM &input, uint32_t id) : Block(id), dirty(false), size_b(SDI4FS_MAX_BYTES_PER_ALIGNED_DATABLOCK) {
+    // no header, the whole block is content
+    readN(input, &data[0], size_b);
+}
+
+DataBlock::DataBlock(uint32_t id, uint32_t size_b) : Block(id), dirty(false), size_b(size_b) {
     // nothing to do here besides superclass constructor
 }
 
+DataBlock::DataBlock(uint32_t id, DataBlock &source) : Block(id), dirty(true), size_b(source.size_b) {
+    memcpy(&data[0], &source.data[0], size_b);
+}
+
 DataBlock::~DataBlock() {
     // empty
 }
 
 bool DataBlock::read(char *target, uint32_t pos, std::size_t n) {
-    if (pos > SDI4FS_MAX_BYTES_PER_DATABLOCK || (pos + n) > SDI4FS_MAX_BYTES_PER_DATABLOCK) {
+    if (pos > size_b || (pos + n) > size_b) {
         std::cout << "fs: error - attempting to read data with out-of-bound positions:" << getId() << " " << pos << " " << n << std::endl;
         return false;
     }
@@ -37,7 +46,7 @@ bool DataBlock::read(char *target, uint32_t pos, std::size_t n) {
 }
 
 bool DataBlock::write(const char *source, uint32_t pos, std::size_t n) {
-    if (pos > SDI4FS_MAX_BYTES_PER_DATABLOCK || (pos + n) > SDI4FS_MAX_BYTES_PER_DATABLOCK) {
+    if (pos > size_b || (pos + n) > size_b) {
         std::cout << "fs: error - attempting to write data with out-of-bound positions:" << getId() << " " << pos << " " << n << std::endl;
         return false;
     }
@@ -46,14 +55,31 @@ bool DataBlock::write(const char *source, uint32_t pos, std::size_t n) {
     return true;
 }
 
+bool DataBlock::copyFrom(DataBlock &source, uint32_t sourcePos, uint32_t pos, std::size_t n) {
+    if (sourcePos > source.size_b || (sourcePos + n) > source.size_b) {
+        std::cout << "fs: error - attempting to copy data with out-of-bound positions:" << source.getId() << " " << sourcePos << " " << n << std::endl;
+        return false;
+    }
+    return write((const char*) &source.data[sourcePos], pos, n);
+}
+
 void DataBlock::save(STREAM &output) {
-    Block::save(output);
+    if (size_b == SDI4FS_MAX_BYTES_PER_ALIGNED_DATABLOCK) {
+        // header is written out-of-line by the fs
+        updateLastWriteTime();
+    } else {
+        Block::save(output);
+    }
     // write content
-    writeN(output, &data[0], SDI4FS_MAX_BYTES_PER_DATABLOCK);
+    writeN(output, &data[0], size_b);
 }
 
 bool DataBlock::isDirty() {
     return dirty;
 }
 
+uint32_t DataBlock::getSize_b() {
+    return size_b;
+}
+
 } // SDI4FS
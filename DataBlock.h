@@ -29,11 +29,29 @@ public:
      */
     DataBlock(STREAM &input);
 
+    /**
+     * Creates an aligned DataBlock (header stored out-of-line) by reading its content from the stream.
+     * Will read SDI4FS_BLOCK_SIZE bytes from the stream.
+     * The caller must call seekg beforehand.
+     * @param input the stream to read from
+     * @param id the block id, taken from the out-of-line header
+     */
+    DataBlock(STREAM &input, uint32_t id);
+
     /**
      * Creates a new DataBlock with the given parameters.
      * @param id the new unique block id
+     * @param size_b content size, SDI4FS_MAX_BYTES_PER_DATABLOCK or SDI4FS_MAX_BYTES_PER_ALIGNED_DATABLOCK (header stored out-of-line)
      */
-    DataBlock(uint32_t id);
+    DataBlock(uint32_t id, uint32_t size_b);
+
+    /**
+     * Creates a new DataBlock with the given id and a copy of the content of another DataBlock.
+     * The new block has the same content size and is dirty (never saved).
+     * @param id the new unique block id
+     * @param source the DataBlock to copy the content from
+     */
+    DataBlock(uint32_t id, DataBlock &source);
     
     /**
      * Reads n bytes from position pos of the content and writes them to target.
@@ -55,6 +73,16 @@ public:
      * @return true, iff successful
      */
     bool write(const char *source, uint32_t pos, std::size_t n);
+
+    /**
+     * Copies n bytes from another DataBlock into this one, without an intermediate buffer.
+     * @param source the DataBlock to copy from
+     * @param sourcePos start position in source
+     * @param pos start position in this DataBlock
+     * @param n number of bytes
+     * @return true, iff successful (both ranges valid)
+     */
+    bool copyFrom(DataBlock &source, uint32_t sourcePos, uint32_t pos, std::size_t n);
     
     /**
      * Returns the dirty bit.
@@ -62,18 +90,30 @@ public:
      */
     bool isDirty();
 
+    /**
+     * Returns the content size in bytes.
+     * @return SDI4FS_MAX_BYTES_PER_DATABLOCK or SDI4FS_MAX_BYTES_PER_ALIGNED_DATABLOCK
+     */
+    uint32_t getSize_b();
+
     virtual void save(STREAM &output);
     virtual ~DataBlock();
 private:
     /**
-     * Content (raw data)
+     * Content (raw data), only the first size_b bytes are used.
      */
-    uint8_t data[SDI4FS_MAX_BYTES_PER_DATABLOCK];
-    
+    uint8_t data[SDI4FS_MAX_BYTES_PER_ALIGNED_DATABLOCK];
+
     /**
      * The dirty bit.
      */
     bool dirty;
+
+    /**
+     * Content size in bytes. A DataBlock with SDI4FS_MAX_BYTES_PER_ALIGNED_DATABLOCK bytes
+     * has no header in its log slot, the fs stores it out-of-line.
+     */
+    uint32_t size_b;
 };
 
 } // SDI4FS
@@ -78,11 +78,23 @@ uint32_t DataBlockList::getDataBlock(size_t index) {
     return entries[index];
 }
 
+bool DataBlockList::setDataBlock(size_t index, uint32_t id) {
+    if (entries.size() <= index) {
+        return false;
+    }
+    entries[index] = id;
+    return true;
+}
+
 void DataBlockList::blocks(std::list<uint32_t> &result) {
     for (uint32_t id : entries) {
         result.push_back(id);
     }
 }
 
+uint32_t DataBlockList::size() {
+    return entries.size();
+}
+
 } // SDI4FS
 
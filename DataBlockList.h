@@ -58,6 +58,14 @@ public:
      */
     uint32_t getDataBlock(size_t index);
 
+    /**
+     * Replaces the stored DataBlock blockID with the given index.
+     * @param index index of an existing entry
+     * @param id the new blockID
+     * @return true, iff successful (index valid)
+     */
+    bool setDataBlock(size_t index, uint32_t id);
+
     /**
      * Fills the given list with the blockIDs of all blocks currently
      * stored in this DataBlockList.
@@ -65,6 +73,12 @@ public:
      */
     void blocks(std::list<uint32_t> &result);
 
+    /**
+     * Returns the number of stored blockIDs.
+     * @return the number of stored blockIDs
+     */
+    uint32_t size();
+
     virtual void save(STREAM &output);
     virtual ~DataBlockList();
 private:
@@ -0,0 +1,49 @@
+/*
+ * File:   DeviceEngine.cpp
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 6:30 PM
+ */
+
+#include "DeviceEngine.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+#include "IDeviceEngine.h"
+#include "PosixDeviceEngine.h"
+#include "UringDeviceEngine.h"
+
+namespace SDI4FS {
+
+IDeviceEngine* openDeviceEngine(const char *path, DeviceEngineType type, uint32_t queueDepth, bool direct) {
+    int fd = open(path, O_RDWR | (direct ? O_DIRECT : 0));
+    if (fd < 0 && direct && errno == EINVAL) {
+        // e.g. tmpfs
+        std::cout << "dev: warning - O_DIRECT not supported for " << path << ", using buffered I/O" << std::endl;
+        fd = open(path, O_RDWR);
+    }
+    if (fd < 0) {
+        std::cout << "dev: error - cannot open " << path << ": " << strerror(errno) << std::endl;
+        return NULL;
+    }
+    if (type != DeviceEngineType::POSIX) {
+        IDeviceEngine *engine = UringDeviceEngine::create(fd, queueDepth);
+        if (engine != NULL) {
+            return engine;
+        }
+        if (type == DeviceEngineType::URING) {
+            std::cout << "dev: error - io_uring not available" << std::endl;
+            close(fd);
+            return NULL;
+        }
+        // fall back
+    }
+    return new PosixDeviceEngine(fd);
+}
+
+} // SDI4FS
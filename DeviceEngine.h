@@ -0,0 +1,53 @@
+/*
+ * File:   DeviceEngine.h
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 6:30 PM
+ */
+
+#ifndef SDI4FS_DEVICEENGINE_H
+#define	SDI4FS_DEVICEENGINE_H
+
+#include <cstdint>
+
+#include "IDeviceEngine.h"
+
+namespace SDI4FS {
+
+/**
+ * Available device engines (linux only).
+ */
+enum class DeviceEngineType {
+    /**
+     * io_uring if available, pread/pwrite otherwise.
+     */
+    AUTO,
+
+    /**
+     * io_uring, fails if not available.
+     */
+    URING,
+
+    /**
+     * pread/pwrite.
+     */
+    POSIX
+};
+
+/**
+ * Opens the given device file with the requested engine.
+ * With direct, the file is opened with O_DIRECT, bypassing the kernel page cache. All requests must then be
+ * 4 KiB-aligned (position, size and memory), as issued by DeviceStreamBuf. Falls back to buffered I/O with a warning
+ * if the file system of the device file does not support O_DIRECT.
+ * Caller is responsible for cleaning up the created object.
+ * @param path path of the device file
+ * @param type the engine
+ * @param queueDepth maximum number of requests in flight (io_uring only)
+ * @param direct true to use O_DIRECT
+ * @return the engine or NULL
+ */
+IDeviceEngine* openDeviceEngine(const char *path, DeviceEngineType type, uint32_t queueDepth, bool direct);
+
+}
+
+#endif	// SDI4FS_DEVICEENGINE_H
@@ -0,0 +1,236 @@
+/*
+ * File:   DeviceStreamBuf.cpp
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 6:10 PM
+ */
+
+#include "DeviceStreamBuf.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <streambuf>
+#include <unordered_map>
+#include <vector>
+
+#include "Constants.inc"
+#include "IDeviceEngine.h"
+
+namespace SDI4FS {
+
+DeviceStreamBuf::DeviceStreamBuf(IDeviceEngine &engine, uint32_t cachePages, uint32_t readaheadPages) : engine(engine), size_b(engine.getSize_b() / SDI4FS_BLOCK_SIZE * SDI4FS_BLOCK_SIZE), pos(0),
+pages(std::max<uint32_t>(cachePages, 2)), memory(NULL), useClock(0), readaheadPages(readaheadPages), lastMiss(UINT64_MAX) {
+    // one readahead batch must never evict the page it was started for
+    this->readaheadPages = std::max<uint32_t>(1, std::min<uint32_t>(readaheadPages, pages.size() / 2));
+    // one allocation for all slots, this is all the memory the cache ever uses
+    void *mem;
+    if (posix_memalign(&mem, SDI4FS_BLOCK_SIZE, pages.size() * SDI4FS_BLOCK_SIZE) != 0) {
+        throw std::bad_alloc();
+    }
+    memory = static_cast<char*> (mem);
+    for (uint32_t i = 0; i < pages.size(); ++i) {
+        pages[i].pageNo = 0;
+        pages[i].lastUse = 0;
+        pages[i].data = memory + (static_cast<std::size_t> (i) * SDI4FS_BLOCK_SIZE);
+        pages[i].valid = false;
+        pages[i].dirty = false;
+    }
+}
+
+DeviceStreamBuf::~DeviceStreamBuf() {
+    writeBack();
+    free(memory);
+}
+
+DeviceStreamBuf::Page* DeviceStreamBuf::getPage(uint64_t pageNo, bool load) {
+    auto iter = index.find(pageNo);
+    if (iter != index.end()) {
+        Page *page = &pages[iter->second];
+        page->lastUse = ++useClock;
+        return page;
+    }
+    if (!load) {
+        // old content is overwritten anyway, no read (and no readahead, this is not a read pattern)
+        Page *slot = allocSlot();
+        if (slot == NULL) {
+            return NULL;
+        }
+        slot->pageNo = pageNo;
+        slot->valid = true;
+        slot->dirty = false;
+        slot->lastUse = ++useClock;
+        index[pageNo] = slot - &pages[0];
+        return slot;
+    }
+    // miss, read ahead if the misses are sequential
+    uint64_t devicePages = size_b / SDI4FS_BLOCK_SIZE;
+    uint64_t count = pageNo == lastMiss + 1 ? readaheadPages : 1;
+    std::vector<DeviceIORequest> batch;
+    std::vector<Page*> slots;
+    for (uint64_t p = pageNo; p < pageNo + count && p < devicePages; ++p) {
+        if (p != pageNo && index.count(p) != 0) {
+            // already cached, stop here
+            break;
+        }
+        Page *slot = allocSlot();
+        if (slot == NULL) {
+            break;
+        }
+        slot->pageNo = p;
+        slot->valid = true;
+        slot->dirty = false;
+        slot->lastUse = ++useClock;
+        index[p] = slot - &pages[0];
+        DeviceIORequest request;
+        request.pos = p * SDI4FS_BLOCK_SIZE;
+        request.buf = slot->data;
+        request.size_b = SDI4FS_BLOCK_SIZE;
+        batch.push_back(request);
+        slots.push_back(slot);
+    }
+    if (slots.empty()) {
+        return NULL;
+    }
+    if (!engine.read(&batch[0], batch.size())) {
+        for (Page *slot : slots) {
+            index.erase(slot->pageNo);
+            slot->valid = false;
+        }
+        return NULL;
+    }
+    lastMiss = slots.back()->pageNo;
+    // the requested page is the most recently used one, the readahead pages may be evicted first
+    slots[0]->lastUse = ++useClock;
+    return slots[0];
+}
+
+DeviceStreamBuf::Page* DeviceStreamBuf::allocSlot() {
+    Page *victim = NULL;
+    for (Page &page : pages) {
+        if (!page.valid) {
+            return &page;
+        }
+        if (victim == NULL || page.lastUse < victim->lastUse) {
+            victim = &page;
+        }
+    }
+    if (victim->dirty && !writeBack()) {
+        return NULL;
+    }
+    index.erase(victim->pageNo);
+    victim->valid = false;
+    return victim;
+}
+
+bool DeviceStreamBuf::writeBack() {
+    std::vector<Page*> dirty;
+    for (Page &page : pages) {
+        if (page.valid && page.dirty) {
+            dirty.push_back(&page);
+        }
+    }
+    if (dirty.empty()) {
+        return true;
+    }
+    // ascending device order, friendlier for the device queue
+    std::sort(dirty.begin(), dirty.end(), [](const Page *a, const Page * b) {
+        return a->pageNo < b->pageNo;
+    });
+    std::vector<DeviceIORequest> batch(dirty.size());
+    for (std::size_t i = 0; i < dirty.size(); ++i) {
+        batch[i].pos = dirty[i]->pageNo * SDI4FS_BLOCK_SIZE;
+        batch[i].buf = dirty[i]->data;
+        batch[i].size_b = SDI4FS_BLOCK_SIZE;
+    }
+    if (!engine.write(&batch[0], batch.size())) {
+        return false;
+    }
+    for (Page *page : dirty) {
+        page->dirty = false;
+    }
+    return true;
+}
+
+std::streamsize DeviceStreamBuf::xsgetn(char *s, std::streamsize n) {
+    std::streamsize done = 0;
+    while (done < n && pos < size_b) {
+        Page *page = getPage(pos / SDI4FS_BLOCK_SIZE);
+        if (page == NULL) {
+            break;
+        }
+        uint32_t offset = pos % SDI4FS_BLOCK_SIZE;
+        std::streamsize chunk = std::min<uint64_t>(std::min<uint64_t>(n - done, SDI4FS_BLOCK_SIZE - offset), size_b - pos);
+        memcpy(s + done, page->data + offset, chunk);
+        done += chunk;
+        pos += chunk;
+    }
+    return done;
+}
+
+std::streamsize DeviceStreamBuf::xsputn(const char *s, std::streamsize n) {
+    std::streamsize done = 0;
+    while (done < n && pos < size_b) {
+        uint32_t offset = pos % SDI4FS_BLOCK_SIZE;
+        std::streamsize chunk = std::min<uint64_t>(std::min<uint64_t>(n - done, SDI4FS_BLOCK_SIZE - offset), size_b - pos);
+        // whole pages (all log slots of saved blocks) need not be read first
+        Page *page = getPage(pos / SDI4FS_BLOCK_SIZE, offset != 0 || chunk != SDI4FS_BLOCK_SIZE);
+        if (page == NULL) {
+            break;
+        }
+        memcpy(page->data + offset, s + done, chunk);
+        page->dirty = true;
+        done += chunk;
+        pos += chunk;
+    }
+    return done;
+}
+
+DeviceStreamBuf::int_type DeviceStreamBuf::underflow() {
+    if (pos >= size_b) {
+        return traits_type::eof();
+    }
+    Page *page = getPage(pos / SDI4FS_BLOCK_SIZE);
+    if (page == NULL) {
+        return traits_type::eof();
+    }
+    return traits_type::to_int_type(page->data[pos % SDI4FS_BLOCK_SIZE]);
+}
+
+DeviceStreamBuf::int_type DeviceStreamBuf::uflow() {
+    int_type c = underflow();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        ++pos;
+    }
+    return c;
+}
+
+DeviceStreamBuf::int_type DeviceStreamBuf::overflow(int_type c) {
+    if (traits_type::eq_int_type(c, traits_type::eof())) {
+        return traits_type::not_eof(c);
+    }
+    char ch = traits_type::to_char_type(c);
+    return xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+}
+
+DeviceStreamBuf::pos_type DeviceStreamBuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+    // get and put position are the same, which does not matter
+    off_type base = dir == std::ios_base::beg ? 0 : (dir == std::ios_base::cur ? pos : size_b);
+    if (base + off < 0) {
+        return pos_type(off_type(-1));
+    }
+    pos = base + off;
+    return pos_type(pos);
+}
+
+DeviceStreamBuf::pos_type DeviceStreamBuf::seekpos(pos_type pos, std::ios_base::openmode which) {
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+int DeviceStreamBuf::sync() {
+    return writeBack() && engine.flush() ? 0 : -1;
+}
+
+} // SDI4FS
@@ -0,0 +1,169 @@
+/*
+ * File:   DeviceStreamBuf.h
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 6:10 PM
+ */
+
+#ifndef SDI4FS_DEVICESTREAMBUF_H
+#define	SDI4FS_DEVICESTREAMBUF_H
+
+#include <cstdint>
+#include <streambuf>
+#include <unordered_map>
+#include <vector>
+
+#include "IDeviceEngine.h"
+
+namespace SDI4FS {
+
+/**
+ * std::streambuf on top of an IDeviceEngine, so an engine can be handed to FS as plain std::iostream (DEV_LINUX).
+ * Keeps a small cache of 4 KiB pages between the fs and the engine, which turns the many small
+ * stream accesses of the fs into batched page transfers:
+ *  - a read miss fetches the page, plus the following pages if the misses are sequential (readahead, e.g. gc scanning the log)
+ *  - writes only dirty the cached page, all dirty pages are written as one batch on flush (pubsync) or when the cache is full
+ *  - a flush also forces the written pages to stable storage (IDeviceEngine::flush)
+ * Partial writes to uncached pages read the page first (the fs writes partial pages, e.g. single header fields),
+ * a write that covers a whole page (every block saved to the log) never reads it.
+ * Only whole pages are accessible, a partial page at the end of the device is ignored (the fs layout is page-aligned).
+ * So every transfer is page-sized, page-aligned and uses a 4 KiB-aligned slot from the pool allocated at construction,
+ * which is what O_DIRECT requires. With O_DIRECT, this cache is the only cache, and cachePages * 4 KiB is its fixed budget.
+ * Get and put position are the same, like std::filebuf.
+ * Not thread-safe, FS serializes all device accesses.
+ */
+class DeviceStreamBuf : public std::streambuf {
+public:
+    /**
+     * Creates a new streambuf.
+     * @param engine the engine, must outlive this streambuf
+     * @param cachePages number of cached pages (memory budget in 4 KiB units), at least 2
+     * @param readaheadPages number of pages fetched per sequential read miss, at least 1
+     */
+    DeviceStreamBuf(IDeviceEngine &engine, uint32_t cachePages, uint32_t readaheadPages);
+
+    /**
+     * Writes back all dirty pages.
+     */
+    virtual ~DeviceStreamBuf();
+
+    DeviceStreamBuf(const DeviceStreamBuf&) = delete;
+    DeviceStreamBuf& operator=(const DeviceStreamBuf&) = delete;
+
+protected:
+    virtual std::streamsize xsgetn(char *s, std::streamsize n);
+
+    virtual std::streamsize xsputn(const char *s, std::streamsize n);
+
+    virtual int_type underflow();
+
+    virtual int_type uflow();
+
+    virtual int_type overflow(int_type c);
+
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which);
+
+    virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which);
+
+    virtual int sync();
+
+private:
+    /**
+     * One cache slot.
+     */
+    struct Page {
+        /**
+         * Page number on the device (byte offset / page size).
+         */
+        uint64_t pageNo;
+
+        /**
+         * Value of useClock at the last access, for LRU eviction.
+         */
+        uint64_t lastUse;
+
+        /**
+         * Start of this page's data, 4 KiB aligned.
+         */
+        char *data;
+
+        /**
+         * True, iff this slot holds a page.
+         */
+        bool valid;
+
+        /**
+         * True, iff data was modified and not yet written back.
+         */
+        bool dirty;
+    };
+
+    /**
+     * Returns the page with the given number, reads it (and maybe readahead pages) on a miss.
+     * @param pageNo the page number
+     * @param load false, if the caller overwrites the whole page, then a miss only allocates a slot and reads nothing
+     * @return the page or NULL on I/O errors
+     */
+    Page* getPage(uint64_t pageNo, bool load = true);
+
+    /**
+     * Returns a free slot, evicts the least recently used page if necessary.
+     * @return the slot or NULL if dirty pages could not be written back
+     */
+    Page* allocSlot();
+
+    /**
+     * Writes all dirty pages as one batch.
+     * @return true, iff successful
+     */
+    bool writeBack();
+
+    /**
+     * The engine.
+     */
+    IDeviceEngine &engine;
+
+    /**
+     * Usable size of the device in bytes, a multiple of the page size.
+     */
+    uint64_t size_b;
+
+    /**
+     * Current get/put position.
+     */
+    uint64_t pos;
+
+    /**
+     * The cache slots.
+     */
+    std::vector<Page> pages;
+
+    /**
+     * Backing memory of all slots, aligned to the page size.
+     */
+    char *memory;
+
+    /**
+     * Page number -> index in pages.
+     */
+    std::unordered_map<uint64_t, uint32_t> index;
+
+    /**
+     * Incremented on every page access.
+     */
+    uint64_t useClock;
+
+    /**
+     * Number of pages fetched on a sequential miss.
+     */
+    uint32_t readaheadPages;
+
+    /**
+     * Page number of the last miss, to detect sequential access.
+     */
+    uint64_t lastMiss;
+};
+
+}
+
+#endif	// SDI4FS_DEVICESTREAMBUF_H
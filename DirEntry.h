@@ -0,0 +1,135 @@
+/*
+ * File:   DirEntry.h
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 2:20 PM
+ */
+
+#ifndef SDI4FS_DIRENTRY_H
+#define	SDI4FS_DIRENTRY_H
+
+#include <cstdint>
+
+#include "Constants.inc"
+
+namespace SDI4FS {
+
+/**
+ * Metadata of a file or directory, as stored in its primary INode.
+ * See FS::ls for the meaning of the size fields.
+ */
+struct StatInfo {
+    /**
+     * Block id of the primary INode.
+     */
+    uint32_t id;
+
+    /**
+     * INode type (SDI4FS_INODE_TYPE_DIR or SDI4FS_INODE_TYPE_REGULARFILE).
+     */
+    uint8_t type;
+
+    /**
+     * Number of hardlinks pointing to this INode.
+     */
+    uint16_t linkCounter;
+
+    /**
+     * File size in bytes, always zero for directories.
+     */
+    uint32_t size_b;
+
+    /**
+     * Size in bytes this entry occupies on disk (multiple of the block size).
+     */
+    uint32_t diskSize_b;
+
+    /**
+     * Unix timestamp of creation.
+     */
+    uint32_t creationTime;
+
+    /**
+     * Unix timestamp of the last modification.
+     */
+    uint32_t lastWriteTime;
+};
+
+/**
+ * One entry of a directory listing, as returned by FS::readdir.
+ */
+struct DirEntry {
+    /**
+     * The hardlink name, NUL-terminated.
+     */
+    char name[SDI4FS_MAX_LINK_NAME_LENGTH];
+
+    /**
+     * Block id of the primary INode the hardlink points to.
+     */
+    uint32_t id;
+
+    /**
+     * INode type of the target, zero if unknown.
+     */
+    uint8_t type;
+
+    /**
+     * Metadata of the target, only filled by FS::readdirplus.
+     */
+    StatInfo stat;
+};
+
+/**
+ * Position within a directory listing, see FS::openDir and FS::readdir.
+ * Only stores the directory, the current DirectoryEntryList and the last returned name, so listing
+ * a directory of any size needs constant memory. Cursors stay valid across other fs calls.
+ * Lists are visited by ascending block id and the entries of a list by ascending name. Both keys are
+ * stable, so entries that exist during the whole listing are returned exactly once, even if other
+ * entries are removed in between. Entries added in between may or may not be returned.
+ */
+class ReaddirCursor {
+public:
+    /**
+     * Creates a cursor that is not bound to any directory yet.
+     */
+    ReaddirCursor() : dirID(0), listID(0), lastName(), end(true) {
+    }
+
+    /**
+     * Returns true, iff all entries have been returned (or the cursor was never opened).
+     * @return true, iff there are no more entries
+     */
+    bool isAtEnd() const {
+        return end;
+    }
+
+private:
+    friend class FS;
+
+    /**
+     * Block id of the primary DirectoryINode, zero if not opened.
+     */
+    uint32_t dirID;
+
+    /**
+     * Block id of the current DirectoryEntryList, zero for inlined directories and before the first list.
+     * If this list was removed, the listing continues with the next higher id.
+     */
+    uint32_t listID;
+
+    /**
+     * Name of the last entry returned from the current list, NUL-terminated, empty if none.
+     */
+    char lastName[SDI4FS_MAX_LINK_NAME_LENGTH];
+
+    /**
+     * Set after the last entry has been returned.
+     */
+    bool end;
+};
+
+} // SDI4FS
+
+#endif	// SDI4FS_DIRENTRY_H
+
@@ -14,6 +14,7 @@
 
 #include "DirectoryINode.h"
 #include "DirectoryEntryList.h"
+#include "HardlinkFilter.h"
 
 namespace SDI4FS {
 
@@ -69,7 +70,7 @@ uint32_t Directory::getChildCount() {
     return childCount;
 }
 
-std::list<Block*> Directory::addHardlink(INode &target, std::string name) {
+std::list<Block*> Directory::addHardlink(INode &target, const PathView &name) {
     std::list<Block*> changedBlocks;
     // already present?
     if (searchHardlink(name) != 0) {
@@ -88,7 +89,7 @@ std::list<Block*> Directory::addHardlink(INode &target, std::string name) {
     }
     changedBlocks.push_back(&target);
 
-    Hardlink *link = new Hardlink(name, target.getId());
+    Hardlink link(name, target.getId());
     bool successInline = false;
     if (inode->isInlined()) {
         // try putting it in here
@@ -104,7 +105,6 @@ std::list<Block*> Directory::addHardlink(INode &target, std::string name) {
         if (newDirEntryList == NULL) {
             std::cout << "fs: error - cannot alloc DirectoryEntryList" << std::endl;
             target.decrementLinkCounter();
-            delete link;
             return changedBlocks;
         }
         // convert primary INode
@@ -135,7 +135,6 @@ std::list<Block*> Directory::addHardlink(INode &target, std::string name) {
             if (newDirEntryList == NULL) {
                 std::cout << "fs: error - cannot alloc DirectoryEntryList(2)" << std::endl;
                 target.decrementLinkCounter();
-                delete link;
                 return changedBlocks;
             }
             // push new link there
@@ -152,24 +151,28 @@ std::list<Block*> Directory::addHardlink(INode &target, std::string name) {
     return changedBlocks;
 }
 
-uint32_t Directory::searchHardlink(std::string name) {
+uint32_t Directory::searchHardlink(const PathView &name) {
     // sanity check
-    if (name.empty() || name.find_first_of('/') != name.npos) {
+    if (name.empty() || name.contains('/')) {
         std::cout << "fs: error - cannot search for hardlink with name \"" << name << "\", not a valid link name" << std::endl;
         return 0;
     }
     if (inode->isInlined()) {
         // search in primary inode only
-        Hardlink *link = inode->findLink(name);
+        const Hardlink *link = inode->findLink(name);
         if (link == NULL) {
             // not found
             return 0;
         }
         return link->getTarget();
     } else {
-        // search in DirEntryLists
+        // search in DirEntryLists, skip those that certainly do not contain the name
+        uint64_t nameHash = HardlinkFilter::hash(name);
         for (auto iter = entryLists.begin(); iter != entryLists.end(); ++iter) {
-            Hardlink *link = (*iter)->findLink(name);
+            if (!(*iter)->mayContainLink(nameHash)) {
+                continue;
+            }
+            const Hardlink *link = (*iter)->findLink(name);
             if (link != NULL) {
                 // found!
                 return link->getTarget();
@@ -180,28 +183,31 @@ uint32_t Directory::searchHardlink(std::string name) {
     }
 }
 
-std::list<Block*> Directory::rmHardlink(INode &target, std::string name) {
+std::list<Block*> Directory::rmHardlink(INode &target, const PathView &name) {
     std::list<Block*> changedBlocks;
     // sanity check
-    if (name.empty() || name.find_first_of('/') != name.npos) {
+    if (name.empty() || name.contains('/')) {
         std::cout << "fs: error - cannot remove hardlink with name \"" << name << "\", not a valid link name" << std::endl;
         return changedBlocks;
     }
     target.decrementLinkCounter();
     changedBlocks.push_back(&target);
     if (inode->isInlined()) {
-        delete inode->removeLink(name);
+        inode->removeLink(name);
         changedBlocks.push_back(&getPrimaryINode());
     } else {
         // search in DirEntryLists
+        uint64_t nameHash = HardlinkFilter::hash(name);
         for (auto iter = entryLists.begin(); iter != entryLists.end(); ++iter) {
-            Hardlink *link = (*iter)->removeLink(name);
-            if (link != NULL) {
-                delete link;
+            if (!(*iter)->mayContainLink(nameHash)) {
+                continue;
+            }
+            if ((*iter)->removeLink(name)) {
                 // removed, list now empty?
                 if ((*iter)->getNumberOfHardlinks() == 0) {
-                    blockCreator->dealloc(*iter);
+                    // forget the list before dealloc, dealloc deletes it
                     inode->removeDirEntryList((*iter)->getId());
+                    blockCreator->dealloc(*iter);
                     entryLists.erase(iter);
                     changedBlocks.push_back(&getPrimaryINode());
                 } else {
@@ -20,6 +20,7 @@
 #include "DirectoryINode.h"
 #include "DirectoryEntryList.h"
 #include "IDirectoryEntryListCreator.h"
+#include "PathUtils.inc"
 
 namespace SDI4FS {
 
@@ -74,7 +75,7 @@ public:
      * @param name the name of the link
      * @return blockID of the link target or zero
      */
-    uint32_t searchHardlink(std::string name);
+    uint32_t searchHardlink(const PathView &name);
 
     /**
      * Returns the number of children this directory has.
@@ -89,7 +90,7 @@ public:
      * @param name link name (max 27 chars + \0, no / or \0 (unchecked!)
      * @return list of modified blocks that need to be saved
      */
-    std::list<Block*> addHardlink(INode &target, std::string name);
+    std::list<Block*> addHardlink(INode &target, const PathView &name);
 
     /**
      * Internal method to remove Hardlinks.
@@ -99,7 +100,7 @@ public:
      * @param name link name to remove
      * @return list of modified blocks that need to be saved
      */
-    std::list<Block*> rmHardlink(INode &target, std::string name);
+    std::list<Block*> rmHardlink(INode &target, const PathView &name);
 
     /**
      * Fills the given list with the names of all hardlinks in this directory.
@@ -14,6 +14,9 @@
 #include <list>
 
 #include "Hardlink.h"
+#include "HardlinkArray.h"
+#include "HardlinkFilter.h"
+#include "PathUtils.inc"
 #include "StreamSelectorHeader.inc"
 
 namespace SDI4FS {
@@ -39,28 +42,34 @@ public:
     DirectoryEntryList(uint32_t id);
 
     /**
-     * Tries to save a reference to the given Hardlink inline in this DirEntryList.
-     * The Hardlink must be located on the heap. If add is successful, this
-     * class will take the responsibility to delete the hardlink.
-     * @param link a pointer to the heap-allocated link to save
+     * Tries to save a copy of the given Hardlink in this DirEntryList.
+     * @param link the link to save
      * @return true, if successful, false if full
      */
-    bool addLink(Hardlink *link);
+    bool addLink(const Hardlink &link);
 
     /**
      * Removes a link from this DirEntryList.
-     * The caller gains responsibility to delete the hardlink.
      * @param linkName the link name
-     * @return the hardlink, or NULL
+     * @return true, iff found (and removed)
      */
-    Hardlink* removeLink(std::string linkName);
+    bool removeLink(const PathView &linkName);
 
     /**
      * Finds a Hardlink by its link name within the contents of this DirEntryList.
+     * The returned pointer is only valid until the next modification of this DirEntryList.
      * @param linkName the link name
      * @return the hardlink, or NULL
      */
-    Hardlink* findLink(std::string linkName);
+    const Hardlink* findLink(const PathView &linkName);
+
+    /**
+     * Quick pre-check for findLink, based on an in-memory Bloom filter over all stored names.
+     * If this returns false, the name is definitely not stored in this DirEntryList.
+     * @param nameHash hash of the link name, see HardlinkFilter::hash()
+     * @return false, iff the name is not stored here
+     */
+    bool mayContainLink(uint64_t nameHash);
 
     /**
      * Returns the number of hardlinks stored in this DirEntryList.
@@ -68,6 +77,13 @@ public:
      */
     uint32_t getNumberOfHardlinks();
 
+    /**
+     * Returns the hardlink with the given index.
+     * @param index the index, must be smaller than getNumberOfHardlinks()
+     * @return the hardlink
+     */
+    const Hardlink& getLink(uint32_t index);
+
     /**
      * Fills the given list with the names of all hardlinks stored in this DirEntryList.
      * Dotfiles included.
@@ -81,7 +97,17 @@ private:
     /**
      * Content of this DirEntryList.
      */
-    std::list<Hardlink*> entries;
+    HardlinkArray entries;
+
+    /**
+     * Bloom filter over the names in entries.
+     */
+    HardlinkFilter filter;
+
+    /**
+     * Re-creates the filter from the current entries (required after removals).
+     */
+    void rebuildFilter();
 };
 
 } // SDI4FS
@@ -9,7 +9,6 @@
 #include "INode.h"
 
 #include <cstdint>
-#include <cstring>
 #include <iostream>
 #include <string>
 
@@ -29,24 +28,7 @@ DirectoryINode::DirectoryINode(STREAM &input) : INode(input), entries(), dirEntr
         // skip unused space
         input.seekg(12, input.cur);
         // read entries
-        for (int i = 0; i < SDI4FS_MAX_LINKS_PER_DIRENTRYLIST; ++i) {
-            uint32_t id;
-            char cname[SDI4FS_MAX_LINK_NAME_LENGTH];
-            read32(input, &id);
-            if (id != 0) {
-                // read name
-                read64(input, (uint64_t*) & cname[0]);
-                read64(input, (uint64_t*) & cname[8]);
-                read64(input, (uint64_t*) & cname[16]);
-                read32(input, (uint32_t*) & cname[24]);
-                // save
-                Hardlink *link = new Hardlink(std::string(cname), id);
-                entries.push_back(link);
-            } else {
-                // skip name
-                input.seekg(SDI4FS_MAX_LINK_NAME_LENGTH, input.cur);
-            }
-        }
+        entries.read(input);
     } else {
         for (int i = 0; i < SDI4FS_MAX_DIRENTRYLISTS_PER_DIR; ++i) {
             uint32_t linkTarget;
@@ -64,10 +46,7 @@ DirectoryINode::DirectoryINode(uint32_t id) : INode(id, SDI4FS_INODE_TYPE_DIR),
 }
 
 DirectoryINode::~DirectoryINode() {
-    // clean up
-    for (auto iter = entries.begin(); iter != entries.end(); ++iter) {
-        delete *iter;
-    }
+    // nothing to clean up, entries are stored by value
 }
 
 void DirectoryINode::setInternalSize_b(uint32_t size_b) {
@@ -81,26 +60,7 @@ void DirectoryINode::save(STREAM &output) {
         // skip unused space
         output.seekp(12, output.cur);
         // write entries
-        for (auto iter = entries.begin(); iter != entries.end(); ++iter) {
-            Hardlink *link = *iter;
-            // write target (id))
-            write32(output, link->getTarget());
-            // write name
-            char cname[SDI4FS_MAX_LINK_NAME_LENGTH];
-            strncpy(cname, link->getLinkName().c_str(), SDI4FS_MAX_LINK_NAME_LENGTH);
-            // better save than sorry
-            cname[SDI4FS_MAX_LINK_NAME_LENGTH - 1] = 0;
-            for (int i = 0; i < SDI4FS_MAX_LINK_NAME_LENGTH; ++i) {
-                write8(output, (uint8_t) cname[i]);
-            }
-        }
-        // null ids of rest
-        for (int i = entries.size(); i < SDI4FS_MAX_LINKS_PER_DIRENTRYLIST; ++i) {
-            // null id
-            write32(output, 0);
-            // skip name
-            output.seekp(SDI4FS_MAX_LINK_NAME_LENGTH, output.cur);
-        }
+        entries.save(output);
     } else {
         // write entries
         for (auto iter = dirEntryListIDs.begin(); iter != dirEntryListIDs.end(); ++iter) {
@@ -115,69 +75,50 @@ void DirectoryINode::save(STREAM &output) {
     }
 }
 
-uint32_t DirectoryINode::getUserVisibleSize_b() {
-    return (dirEntryListIDs.size() + 1) * SDI4FS_BLOCK_SIZE; // +1 is self
-}
-
-bool DirectoryINode::addLink(Hardlink *link) {
+bool DirectoryINode::addLink(const Hardlink &link) {
     // sanity check
     if (!isInlined()) {
         std::cout << "fs: error - cannot push hardlink to non-inlined INode, id " << getId() << std::endl;
         return false;
     }
-    // size check
-    if (entries.size() >= SDI4FS_MAX_LINKS_PER_DIRENTRYLIST) {
-        // full
-        return false;
-    }
-    // all ok
-    entries.push_back(link);
-    return true;
+    // size check is done by the array
+    return entries.add(link);
 }
 
-Hardlink* DirectoryINode::removeLink(std::string linkName) {
+bool DirectoryINode::removeLink(const PathView &linkName) {
     // sanity check
     if (!isInlined()) {
         std::cout << "fs: error - cannot remove hardlink in non-inlined INode, id " << getId() << std::endl;
-        return NULL;
+        return false;
     }
-    for (auto iter = entries.begin(); iter != entries.end(); ++iter) {
-        if (!(*iter)->getLinkName().compare(linkName)) {
-            Hardlink *link = *iter;
-            entries.erase(iter);
-            return link;
-        }
+    if (entries.remove(linkName)) {
+        return true;
     }
 
     // not found, should never happen
     std::cout << "fs: error - cannot remove hardlink from non-inlined INode, id " << getId() << ", link \"" << linkName << "\" not found" << std::endl;
-    return NULL;
+    return false;
 }
 
-Hardlink* DirectoryINode::findLink(std::string linkName) {
+const Hardlink* DirectoryINode::findLink(const PathView &linkName) {
     // sanity check
     if (!isInlined()) {
         std::cout << "fs: error - cannot find hardlink in non-inlined INode, id " << getId() << std::endl;
         return NULL;
     }
-    for (auto iter = entries.begin(); iter != entries.end(); ++iter) {
-        if (!(*iter)->getLinkName().compare(linkName)) {
-            // found
-            return *iter;
-        }
-    }
-    // not found
-    return NULL;
+    return entries.find(linkName);
 }
 
 uint32_t DirectoryINode::getNumberOfHardlinks() {
     return entries.size();
 }
 
+const Hardlink& DirectoryINode::getLink(uint32_t index) {
+    return entries.get(index);
+}
+
 void DirectoryINode::ls(std::list<std::string> &result) {
-    for (Hardlink *link : entries) {
-        result.push_back(link->getLinkName());
-    }
+    entries.ls(result);
 }
 
 const std::list<uint32_t>& DirectoryINode::getDirEntryListIDs() {
@@ -231,8 +172,8 @@ void DirectoryINode::convertToNonInline(DirectoryEntryList *entryList) {
     }
 
     // save entries in new list (external block)
-    for (auto iter = entries.begin(); iter != entries.end(); ++iter) {
-        if (!entryList->addLink(*iter)) {
+    for (uint32_t i = 0; i < entries.size(); ++i) {
+        if (!entryList->addLink(entries.get(i))) {
             // should never happen
             std::cout << "fs: error - (while converting to non-inline dir) cannot store a hardlink " << std::endl;
             return;
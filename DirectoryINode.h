@@ -15,6 +15,8 @@
 #include <list>
 
 #include "Hardlink.h"
+#include "HardlinkArray.h"
+#include "PathUtils.inc"
 #include "DirectoryEntryList.h"
 #include "StreamSelectorHeader.inc"
 
@@ -46,28 +48,26 @@ public:
     virtual void setInternalSize_b(uint32_t size_b);
 
     /**
-     * Tries to save a reference to the given Hardlink inline in this INode.
-     * The Hardlink must be located on the heap. If add is successful, this
-     * class will take the responsibility to delete the hardlink.
-     * @param link a pointer to the heap-allocated link to save
+     * Tries to save a copy of the given Hardlink inline in this INode.
+     * @param link the link to save
      * @return true, if successful, false if full
      */
-    bool addLink(Hardlink *link);
+    bool addLink(const Hardlink &link);
 
     /**
      * Removes a inline-stored link from this INode.
-     * The caller gains responsibility to delete the hardlink.
      * @param linkName the link name
-     * @return the hardlink, or NULL
+     * @return true, iff found (and removed)
      */
-    Hardlink* removeLink(std::string linkName);
+    bool removeLink(const PathView &linkName);
 
     /**
      * Finds a Hardlink by its link name within the inline-contents of this inode.
+     * The returned pointer is only valid until the next modification of this INode.
      * @param linkName the link name
      * @return the hardlink, or NULL
      */
-    Hardlink* findLink(std::string linkName);
+    const Hardlink* findLink(const PathView &linkName);
 
     /**
      * Returns the number of hardlinks stored inline in this DirectoryINode.
@@ -75,6 +75,13 @@ public:
      */
     uint32_t getNumberOfHardlinks();
 
+    /**
+     * Returns the inline hardlink with the given index.
+     * @param index the index, must be smaller than getNumberOfHardlinks()
+     * @return the hardlink
+     */
+    const Hardlink& getLink(uint32_t index);
+
     /**
      * Fills the given list with the names of all hardlinks stored inline in this DirectoryINode.
      * Dotfiles included.
@@ -111,12 +118,11 @@ public:
     bool removeDirEntryList(uint32_t blockID);
 
     virtual void save(STREAM &output);
-    virtual uint32_t getUserVisibleSize_b();
 private:
     /**
      * Content of this INode, if data is inline.
      */
-    std::list<Hardlink*> entries;
+    HardlinkArray entries;
 
     /**
      * Content of this INode, if data is non-inline.
@@ -0,0 +1,178 @@
+/*
+ * File:   ExtentMap.cpp
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 9:05 PM
+ */
+
+#include "ExtentMap.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <vector>
+
+#include "Constants.inc"
+#include "StreamUtils.inc"
+
+namespace SDI4FS {
+
+ExtentMap::ExtentMap() : extents(), starts(), numberOfBlocks(0) {
+}
+
+void ExtentMap::read(STREAM &input) {
+    clear();
+    for (uint32_t i = 0; i < SDI4FS_MAX_EXTENTS_PER_FILE; ++i) {
+        Extent extent;
+        read32(input, &extent.firstID);
+        read32(input, &extent.count);
+        if (extent.firstID == 0 || extent.count == 0) {
+            // no gaps allowed
+            break;
+        }
+        extents.push_back(extent);
+        starts.push_back(numberOfBlocks);
+        numberOfBlocks += extent.count;
+    }
+}
+
+void ExtentMap::save(STREAM &output) {
+    for (const Extent &extent : extents) {
+        write32(output, extent.firstID);
+        write32(output, extent.count);
+    }
+    // null rest
+    for (uint32_t i = extents.size(); i < SDI4FS_MAX_EXTENTS_PER_FILE; ++i) {
+        write32(output, 0);
+        write32(output, 0);
+    }
+}
+
+uint32_t ExtentMap::size() const {
+    return numberOfBlocks;
+}
+
+uint32_t ExtentMap::getNumberOfExtents() const {
+    return extents.size();
+}
+
+uint32_t ExtentMap::get(uint32_t blockNo) const {
+    if (blockNo >= numberOfBlocks) {
+        return 0;
+    }
+    uint32_t index = find(blockNo);
+    return extents[index].firstID + (blockNo - starts[index]);
+}
+
+bool ExtentMap::push(uint32_t id) {
+    if (!extents.empty() && extents.back().firstID + extents.back().count == id) {
+        // continues the last run
+        ++extents.back().count;
+    } else {
+        if (extents.size() == SDI4FS_MAX_EXTENTS_PER_FILE) {
+            // full
+            return false;
+        }
+        extents.push_back({id, 1});
+        starts.push_back(numberOfBlocks);
+    }
+    ++numberOfBlocks;
+    return true;
+}
+
+uint32_t ExtentMap::pop() {
+    if (extents.empty()) {
+        return 0;
+    }
+    Extent &last = extents.back();
+    uint32_t result = last.firstID + last.count - 1;
+    if (--last.count == 0) {
+        extents.pop_back();
+        starts.pop_back();
+    }
+    --numberOfBlocks;
+    return result;
+}
+
+bool ExtentMap::set(uint32_t blockNo, uint32_t id) {
+    if (blockNo >= numberOfBlocks) {
+        return false;
+    }
+    uint32_t index = find(blockNo);
+    const Extent extent = extents[index];
+    uint32_t offset = blockNo - starts[index];
+    if (extent.firstID + offset == id) {
+        // nothing to do
+        return true;
+    }
+    // the window [first, last] of extents is replaced, it includes the neighbors so the new block can join their runs
+    uint32_t first = index > 0 ? index - 1 : index;
+    uint32_t last = index + 1 < extents.size() ? index + 1 : index;
+    std::vector<Extent> pieces;
+    if (first != index) {
+        pieces.push_back(extents[first]);
+    }
+    if (offset > 0) {
+        pieces.push_back({extent.firstID, offset});
+    }
+    pieces.push_back({id, 1});
+    if (offset + 1 < extent.count) {
+        pieces.push_back({extent.firstID + offset + 1, extent.count - offset - 1});
+    }
+    if (last != index) {
+        pieces.push_back(extents[last]);
+    }
+    // merge adjacent runs
+    std::vector<Extent> merged;
+    for (const Extent &piece : pieces) {
+        if (!merged.empty() && merged.back().firstID + merged.back().count == piece.firstID) {
+            merged.back().count += piece.count;
+        } else {
+            merged.push_back(piece);
+        }
+    }
+    uint32_t windowSize = last - first + 1;
+    if (extents.size() - windowSize + merged.size() > SDI4FS_MAX_EXTENTS_PER_FILE) {
+        // full
+        return false;
+    }
+    extents.erase(extents.begin() + first, extents.begin() + last + 1);
+    extents.insert(extents.begin() + first, merged.begin(), merged.end());
+    starts.resize(extents.size());
+    updateStarts(first);
+    return true;
+}
+
+bool ExtentMap::isAlmostFull() const {
+    // set splits one extent into up to three
+    return extents.size() + 2 > SDI4FS_MAX_EXTENTS_PER_FILE;
+}
+
+void ExtentMap::blocks(std::list<uint32_t> &result) const {
+    for (const Extent &extent : extents) {
+        for (uint32_t i = 0; i < extent.count; ++i) {
+            result.push_back(extent.firstID + i);
+        }
+    }
+}
+
+void ExtentMap::clear() {
+    extents.clear();
+    starts.clear();
+    numberOfBlocks = 0;
+}
+
+uint32_t ExtentMap::find(uint32_t blockNo) const {
+    // last extent that starts at or before blockNo
+    return std::upper_bound(starts.begin(), starts.end(), blockNo) - starts.begin() - 1;
+}
+
+void ExtentMap::updateStarts(uint32_t from) {
+    uint32_t start = from == 0 ? 0 : starts[from - 1] + extents[from - 1].count;
+    for (uint32_t i = from; i < extents.size(); ++i) {
+        starts[i] = start;
+        start += extents[i].count;
+    }
+}
+
+} // SDI4FS
@@ -0,0 +1,154 @@
+/*
+ * File:   ExtentMap.h
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 9:05 PM
+ */
+
+#ifndef SDI4FS_EXTENTMAP_H
+#define	SDI4FS_EXTENTMAP_H
+
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <vector>
+
+#include "Constants.inc"
+#include "StreamSelectorHeader.inc"
+
+namespace SDI4FS {
+
+/**
+ * Maps the DataBlocks of a file (block numbers) to blockIDs, as stored in the content area of extent-mapped FileINodes.
+ * Each extent is a run of consecutive blockIDs (first id + count), so a sequentially written file
+ * needs only a handful of entries instead of one DataBlockList entry per DataBlock.
+ * Extents are always normalized: no empty extents, and an extent never continues the run of its predecessor.
+ * Capacity is SDI4FS_MAX_EXTENTS_PER_FILE extents, the number of blocks per extent is not limited.
+ */
+class ExtentMap {
+public:
+    /**
+     * Creates an empty ExtentMap.
+     */
+    ExtentMap();
+
+    /**
+     * Reads up to SDI4FS_MAX_EXTENTS_PER_FILE extents from the stream, stops at the first empty extent.
+     * The caller must call seekg beforehand.
+     * @param input the stream to read from
+     */
+    void read(STREAM &input);
+
+    /**
+     * Writes SDI4FS_MAX_EXTENTS_PER_FILE extents (unused ones zeroed) to the stream.
+     * The caller must call seekp beforehand.
+     * @param output the stream to write into
+     */
+    void save(STREAM &output);
+
+    /**
+     * Returns the number of mapped DataBlocks.
+     * @return the number of mapped DataBlocks
+     */
+    uint32_t size() const;
+
+    /**
+     * Returns the number of stored extents.
+     * @return the number of stored extents
+     */
+    uint32_t getNumberOfExtents() const;
+
+    /**
+     * Returns the blockID of the nth DataBlock.
+     * @param blockNo number of the data block, starts at zero
+     * @return blockID or zero
+     */
+    uint32_t get(uint32_t blockNo) const;
+
+    /**
+     * Appends a DataBlock. Extends the last extent, if id directly follows it.
+     * @param id the blockID to add
+     * @return true, iff successful, false if a new extent is required and the map is full
+     */
+    bool push(uint32_t id);
+
+    /**
+     * Removes and returns the blockID of the last DataBlock.
+     * @return the now removed blockID or zero, if empty
+     */
+    uint32_t pop();
+
+    /**
+     * Replaces the blockID of the nth DataBlock.
+     * Splits the affected extent, merges with neighbors if possible.
+     * @param blockNo number of the data block, starts at zero
+     * @param id the new blockID
+     * @return true, iff successful, false if blockNo is invalid or the map would overflow
+     */
+    bool set(uint32_t blockNo, uint32_t id);
+
+    /**
+     * Returns true, iff the next push or set may need more extents than are available.
+     * @return true, iff the map is (almost) full
+     */
+    bool isAlmostFull() const;
+
+    /**
+     * Fills the given list with the blockIDs of all mapped DataBlocks, in file order.
+     * @param result the list to fill
+     */
+    void blocks(std::list<uint32_t> &result) const;
+
+    /**
+     * Removes all extents.
+     */
+    void clear();
+
+private:
+    /**
+     * A run of consecutive blockIDs.
+     */
+    struct Extent {
+        /**
+         * The first blockID.
+         */
+        uint32_t firstID;
+
+        /**
+         * Number of blocks, never zero in memory.
+         */
+        uint32_t count;
+    };
+
+    /**
+     * Returns the index of the extent that holds the given block.
+     * @param blockNo number of the data block, must be smaller than size()
+     * @return the extent index
+     */
+    uint32_t find(uint32_t blockNo) const;
+
+    /**
+     * Recalculates starts, beginning with the given extent.
+     * @param from index of the first extent with an outdated start
+     */
+    void updateStarts(uint32_t from);
+
+    /**
+     * The extents, in file order.
+     */
+    std::vector<Extent> extents;
+
+    /**
+     * starts[i] is the number of the first block of extents[i], used for binary search.
+     */
+    std::vector<uint32_t> starts;
+
+    /**
+     * Total number of blocks.
+     */
+    uint32_t numberOfBlocks;
+};
+
+} // SDI4FS
+
+#endif	// SDI4FS_EXTENTMAP_H
@@ -7,32 +7,52 @@
 
 #include "FS.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <sstream>
+#include <vector>
 
+#include "AtomicUtils.inc"
 #include "Constants.inc"
 #include "PathUtils.inc"
 #include "StreamUtils.inc"
 #include "INode.h"
 #include "IDataBlockListCreator.h"
 #include "IDirectoryEntryListCreator.h"
+#include "IOQueue.h"
+#include "IOVec.h"
 #include "IPrimaryINodeHolder.h"
 #include "DirectoryINode.h"
 #include "Directory.h"
 #include "FileINode.h"
 #include "File.h"
+#include "HardlinkSearch.h"
 #include "ListUtils.inc"
 #include "TimeUtils.inc"
 
 namespace SDI4FS {
 
-FS::FS(STREAM &dev)
-: dev(dev), bmapStart_bptr(SDI4FS_HEADER_SIZE),
-dev_bmap_valid(false) {
+FS::FS(STREAM &dev, bool readOnly)
+: dev(dev), readOnly(readOnly), bmapStart_bptr(SDI4FS_HEADER_SIZE), bmap(NULL), inodeTypes(NULL),
+dev_bmap_valid(false), reservedBlocks(0), ioQueue(SDI4FS_ASYNC_IO_THREADS), lastSnapshotID(0), pinnedBlocks(0), sharedBlocksTable(0) {
+    mount(NULL, 0);
+}
+
+FS::FS(STREAM &dev, FS &origin, uint32_t snapshotID)
+: dev(dev), readOnly(true), bmapStart_bptr(SDI4FS_HEADER_SIZE), bmap(NULL), inodeTypes(NULL),
+dev_bmap_valid(false), reservedBlocks(0), ioQueue(SDI4FS_ASYNC_IO_THREADS), lastSnapshotID(0), pinnedBlocks(0), sharedBlocksTable(0) {
+    mount(&origin, snapshotID);
+}
+
+void FS::mount(FS *origin, uint32_t snapshotID) {
     std::cout << "fs: accessing block device..." << std::endl;
     // read header
     if (!readHeader()) {
@@ -46,6 +66,10 @@ dev_bmap_valid(false) {
         std::cout << "fs: error - invalid header (step 2)" << std::endl;
         return;
     }
+    if (coldWritePtr == 0 || coldWritePtr > logSize) {
+        // not set yet, start the cold head in the middle of the log
+        coldWritePtr = logSize / 2 + 1;
+    }
 
     // callbacks (block creators)
     initCallbacks();
@@ -57,14 +81,28 @@ dev_bmap_valid(false) {
         std::cout << "fs: error - cannot allocate memory for bmap, ERRNO " << bmap << std::endl;
         return;
     }
+    // 4 entries per byte
+    inodeTypes = (uint8_t*) calloc(1, (logSize + 3) / 4);
+    if (inodeTypes == NULL) {
+        std::cout << "fs: error - cannot allocate memory for INode type map" << std::endl;
+        return;
+    }
 
     // load or reconstruct bmap
-    if (dev_bmap_valid) {
+    if (origin != NULL) {
+        // snapshot view, the device state does not matter
+        if (!origin->copySnapshotBMap(snapshotID, bmap, usedBlocks)) {
+            std::cout << "fs: error - no snapshot " << snapshotID << std::endl;
+            return;
+        }
+        std::cout << "fs: using snapshot " << snapshotID << std::endl;
+    } else if (dev_bmap_valid) {
         // load bmap
         if (!loadBMap()) {
             std::cout << "fs: error - cannot load bmap" << std::endl;
             return;
         }
+        loadSharedBlocks();
 #ifndef DEV_LINUX
         // for systems without rtc
         dev.seekg(32);
@@ -77,19 +115,48 @@ dev_bmap_valid(false) {
     }
 
     // mark bmap dirty (fs mounted)
-    dev.seekp(20);
-    write32(dev, 0);
+    if (readOnly) {
+        std::cout << "fs: mounted read-only" << std::endl;
+    } else {
+        dev.seekp(20);
+        write32(dev, 0);
+    }
 
     // all ok
+    std::cout << "fs: using " << hardlinkSearchKernelName() << " hardlink search" << std::endl;
     std::cout << "fs: " << size_b << "B total, " << usedBlocks << " of " << logSize << " blocks in use" << std::endl;
     std::cout << "fs: ready." << std::endl;
 }
 
 void FS::umount() {
+    // finish queued async requests first, they need the locks
+    ioQueue.shutdown();
+    std::lock_guard<RWLock> fsGuard(fsLock);
+    {
+        // snapshots refer to the live bmap
+        std::lock_guard<std::mutex> allocGuard(allocLock);
+        snapshots.clear();
+        pinnedBlocks = 0;
+        reservedBlocks = 0;
+    }
+    // the table is written to the log, so this must happen before the bmap is saved
+    bool sharedBlocksSaved = readOnly || saveSharedBlocks();
+    std::lock_guard<std::mutex> devGuard(devLock);
+    if (readOnly) {
+        // nothing was written, nothing to save
+        free(bmap);
+        bmap = 0;
+        free(inodeTypes);
+        inodeTypes = 0;
+        std::cout << "fs: unmount ok." << std::endl;
+        return;
+    }
     saveBMap();
     // delete bmap
     free(bmap);
     bmap = 0;
+    free(inodeTypes);
+    inodeTypes = 0;
     // save write_ptr
     dev.seekp(16);
     write32(dev, write_ptr);
@@ -104,7 +171,21 @@ void FS::umount() {
 #else
     write32(dev, pseudoTime++);
 #endif
+    // shared block table
+    write32(dev, sharedBlocksTable);
+    // next write sequence number
+    dev.seekp(48);
+    write64(dev, nextSequence);
+    // cold log head
+    write32(dev, coldWritePtr);
     dev.seekp(20);
+    if (!sharedBlocksSaved) {
+        // without the table, freeing a shared DataBlock would corrupt its other files, the next mount must rebuild it
+        std::cout << "fs: error - cannot save shared block table, next mount will reconstruct the bmap" << std::endl;
+        write32(dev, 0);
+        dev.flush();
+        return;
+    }
     // mark unmount complete
     write32(dev, 1);
     // make sure changes were written to disk
@@ -116,6 +197,17 @@ FS::~FS() {
     delete dirEntryListCreator;
 }
 
+bool FS::isReadOnly() const {
+    return readOnly;
+}
+
+bool FS::rejectReadOnly(const char *operation) {
+    if (readOnly) {
+        std::cout << "fs: " << operation << " failed, fs is mounted read-only" << std::endl;
+    }
+    return readOnly;
+}
+
 bool FS::readHeader() {
     dev.seekg(0);
     uint32_t magic;
@@ -159,6 +251,21 @@ bool FS::readHeader() {
         return false;
     }
 
+    // feature bits (zero for images without optional features)
+    dev.seekg(40);
+    read32(dev, &features);
+    if ((features & ~SDI4FS_FEATURE_OUT_OF_LINE_HEADERS) != 0) {
+        std::cout << "error, unsupported features " << features << std::endl;
+        return false;
+    }
+
+    // next write sequence number (only used with out-of-line headers)
+    dev.seekg(48);
+    read64(dev, &nextSequence);
+
+    // cold log head (checked after calcLayout)
+    read32(dev, &coldWritePtr);
+
     return true;
 }
 
@@ -166,10 +273,24 @@ void FS::calcLayout() {
     // bmap requires min 1/1024 of total size (rounded up to 4K blocks)
 
     bmapSize_b = ceil(((size_b - SDI4FS_HEADER_SIZE) / 1024) / 4096.0) * 4096;
+    if ((features & SDI4FS_FEATURE_OUT_OF_LINE_HEADERS) != 0) {
+        // summary area after bmap, 1 summary block per SDI4FS_SLOTS_PER_SEGMENT log slots, log fills up rest
+        uint64_t blocks = (size_b - SDI4FS_HEADER_SIZE - bmapSize_b) / 4096;
+        uint64_t summaryBlocks = (blocks + SDI4FS_SLOTS_PER_SEGMENT) / (SDI4FS_SLOTS_PER_SEGMENT + 1);
+        summaryStart_bptr = bmapStart_bptr + bmapSize_b;
+        summaryCacheSegment = UINT32_MAX;
+        logStart_bptr = summaryStart_bptr + summaryBlocks * 4096;
+        logSize = blocks - summaryBlocks;
+        // DataBlocks have no header in the log
+        dataBlockSize_b = SDI4FS_MAX_BYTES_PER_ALIGNED_DATABLOCK;
+        return;
+    }
+    summaryStart_bptr = 0;
     // log starts after bmap
     logStart_bptr = bmapStart_bptr + bmapSize_b;
     // log fills up rest
     logSize = (size_b - SDI4FS_HEADER_SIZE - bmapSize_b) / 4096;
+    dataBlockSize_b = SDI4FS_MAX_BYTES_PER_DATABLOCK;
 }
 
 bool FS::loadBMap() {
@@ -196,27 +317,63 @@ uint32_t FS::lookupBlockAddress(uint32_t id) {
 
         return 0;
     }
-    return bmap[id - 1];
+    return loadBMapEntry(&bmap[id - 1]);
 }
 
-std::unique_ptr<Directory> FS::loadDirectory(uint32_t id) {
-    // get pos in log
-    uint32_t logPtr = lookupBlockAddress(id);
-    if (logPtr == 0 || logPtr > logSize) {
-        std::cout << "fs: error - inode not found: " << id << std::endl;
-        return std::unique_ptr<Directory>(nullptr);
-    }
-    // seek to pos
-    dev.seekg(logStart_bptr + ((logPtr - 1) * SDI4FS_BLOCK_SIZE));
-    // read inode
-    std::unique_ptr<DirectoryINode> inode(new DirectoryINode(dev));
-    // sanity checks
-    if (inode->getId() != id) {
-        std::cout << "fs: error - inconsistency, tried to load inode " << id << ", but got " << inode->getId() << std::endl;
-        return std::unique_ptr<Directory>(nullptr);
+namespace {
+
+/**
+ * Creates a block of type T from the stream, which must be positioned at the start of the log slot of the block.
+ * @param dev the stream to read from
+ * @param id the blockID from the header of the slot
+ * @param outOfLineHeaders true, iff block headers are stored in the summary area
+ * @return the new block
+ */
+template <typename T>
+T* newBlockFromLog(STREAM &dev, uint32_t id, bool outOfLineHeaders) {
+    // all blocks except DataBlocks keep their header in the slot
+    return new T(dev);
+}
+
+template <>
+DataBlock* newBlockFromLog<DataBlock>(STREAM &dev, uint32_t id, bool outOfLineHeaders) {
+    return outOfLineHeaders ? new DataBlock(dev, id) : new DataBlock(dev);
+}
+
+} // anonymous namespace
+
+template <typename T>
+std::unique_ptr<T> FS::readBlock(uint32_t id, const char *what) {
+    while (true) {
+        // lock-free
+        uint32_t logPtr = lookupBlockAddress(id);
+        if (logPtr == 0 || logPtr > logSize) {
+            std::cout << "fs: error - " << what << " not found: " << id << std::endl;
+            return std::unique_ptr<T>(nullptr);
+        }
+        uint64_t blockStart = logStart_bptr + (static_cast<uint64_t> (logPtr - 1) * SDI4FS_BLOCK_SIZE);
+        uint32_t foundID;
+        uint32_t writeTime;
+        {
+            std::lock_guard<std::mutex> devGuard(devLock);
+            readSlotHeader(logPtr, &foundID, &writeTime);
+            if (foundID == id) {
+                dev.seekg(blockStart);
+                return std::unique_ptr<T>(newBlockFromLog<T>(dev, id, (features & SDI4FS_FEATURE_OUT_OF_LINE_HEADERS) != 0));
+            }
+        }
+        // the block was moved after the lookup and its old slot already reused, try again
+        if (lookupBlockAddress(id) != logPtr) {
+            continue;
+        }
+        std::cout << "fs: error - inconsistency, tried to load " << what << " " << id << ", but got " << foundID << std::endl;
+        return std::unique_ptr<T>(nullptr);
     }
-    if (inode->getType() != SDI4FS_INODE_TYPE_DIR) {
-        std::cout << "fs: error - inconsistency, tried to load inode with type " << SDI4FS_INODE_TYPE_DIR << ", but got " << inode->getType() << std::endl;
+}
+
+std::unique_ptr<Directory> FS::loadDirectory(uint32_t id) {
+    std::unique_ptr<DirectoryINode> inode = loadDirectoryINode(id);
+    if (!inode) {
         return std::unique_ptr<Directory>(nullptr);
     }
 
@@ -239,42 +396,29 @@ std::unique_ptr<Directory> FS::loadDirectory(uint32_t id) {
     return dir;
 }
 
-std::unique_ptr<DirectoryEntryList> FS::loadDirEntryList(uint32_t id) {
-    // get pos in log
-    uint32_t logPtr = lookupBlockAddress(id);
-    if (logPtr == 0 || logPtr > logSize) {
-        std::cout << "fs: error - dirEntryList not found: " << id << std::endl;
-        return std::unique_ptr<DirectoryEntryList>(nullptr);
+std::unique_ptr<DirectoryINode> FS::loadDirectoryINode(uint32_t id) {
+    std::unique_ptr<DirectoryINode> inode = readBlock<DirectoryINode>(id, "inode");
+    if (!inode) {
+        return std::unique_ptr<DirectoryINode>(nullptr);
     }
-    // seek to pos
-    dev.seekg(logStart_bptr + ((logPtr - 1) * SDI4FS_BLOCK_SIZE));
-    std::unique_ptr<DirectoryEntryList> newDirEntryList(new DirectoryEntryList(dev));
-    // sanity checks
-    if (newDirEntryList->getId() != id) {
-        std::cout << "fs: error - inconsistency, tried to load dirEntryList " << id << ", but got " << newDirEntryList->getId() << std::endl;
+    if (inode->getType() != SDI4FS_INODE_TYPE_DIR) {
+        std::cout << "fs: error - inconsistency, tried to load inode with type " << SDI4FS_INODE_TYPE_DIR << ", but got " << inode->getType() << std::endl;
+        return std::unique_ptr<DirectoryINode>(nullptr);
+    }
+    return inode;
+}
+
+std::unique_ptr<DirectoryEntryList> FS::loadDirEntryList(uint32_t id) {
+    std::unique_ptr<DirectoryEntryList> newDirEntryList = readBlock<DirectoryEntryList>(id, "dirEntryList");
+    if (!newDirEntryList) {
         return std::unique_ptr<DirectoryEntryList>(nullptr);
     }
     return newDirEntryList;
 }
 
 std::unique_ptr<File> FS::loadFile(uint32_t id) {
-    // get pos in log
-    uint32_t logPtr = lookupBlockAddress(id);
-    if (logPtr == 0 || logPtr > logSize) {
-        std::cout << "fs: error - inode not found: " << id << std::endl;
-        return std::unique_ptr<File>(nullptr);
-    }
-    // seek to pos
-    dev.seekg(logStart_bptr + ((logPtr - 1) * SDI4FS_BLOCK_SIZE));
-    // read inode
-    std::unique_ptr<FileINode> inode(new FileINode(dev));
-    // sanity checks
-    if (inode->getId() != id) {
-        std::cout << "fs: error - inconsistency, tried to load inode " << id << ", but got " << inode->getId() << std::endl;
-        return std::unique_ptr<File>(nullptr);
-    }
-    if (inode->getType() != SDI4FS_INODE_TYPE_REGULARFILE) {
-        std::cout << "fs: error - inconsistency, tried to load inode with type " << SDI4FS_INODE_TYPE_REGULARFILE << ", but got " << inode->getType() << std::endl;
+    std::unique_ptr<FileINode> inode = loadFileINode(id);
+    if (!inode) {
         return std::unique_ptr<File>(nullptr);
     }
 
@@ -297,43 +441,159 @@ std::unique_ptr<File> FS::loadFile(uint32_t id) {
     return file;
 }
 
-std::unique_ptr<DataBlockList> FS::loadDataBlockList(uint32_t id) {
-    // get pos in log
-    uint32_t logPtr = lookupBlockAddress(id);
-    if (logPtr == 0 || logPtr > logSize) {
-        std::cout << "fs: error - dataBlockList not found: " << id << std::endl;
-        return std::unique_ptr<DataBlockList>(nullptr);
+std::unique_ptr<FileINode> FS::loadFileINode(uint32_t id) {
+    std::unique_ptr<FileINode> inode = readBlock<FileINode>(id, "inode");
+    if (!inode) {
+        return std::unique_ptr<FileINode>(nullptr);
     }
-    // seek to pos
-    dev.seekg(logStart_bptr + ((logPtr - 1) * SDI4FS_BLOCK_SIZE));
-    std::unique_ptr<DataBlockList> newDataBlockList(new DataBlockList(dev));
-    // sanity checks
-    if (newDataBlockList->getId() != id) {
-        std::cout << "fs: error - inconsistency, tried to load DataBlockList " << id << ", but got " << newDataBlockList->getId() << std::endl;
+    if (inode->getType() != SDI4FS_INODE_TYPE_REGULARFILE) {
+        std::cout << "fs: error - inconsistency, tried to load inode with type " << SDI4FS_INODE_TYPE_REGULARFILE << ", but got " << inode->getType() << std::endl;
+        return std::unique_ptr<FileINode>(nullptr);
+    }
+    return inode;
+}
+
+std::unique_ptr<DataBlockList> FS::loadDataBlockList(uint32_t id) {
+    std::unique_ptr<DataBlockList> newDataBlockList = readBlock<DataBlockList>(id, "DataBlockList");
+    if (!newDataBlockList) {
         return std::unique_ptr<DataBlockList>(nullptr);
     }
     return newDataBlockList;
 }
 
 std::unique_ptr<DataBlock> FS::loadDataBlock(uint32_t id) {
-    // get pos in log
-    uint32_t logPtr = lookupBlockAddress(id);
-    if (logPtr == 0 || logPtr > logSize) {
-        std::cout << "fs: error - dataBlock not found: " << id << std::endl;
-        return std::unique_ptr<DataBlock>(nullptr);
-    }
-    // seek to pos
-    dev.seekg(logStart_bptr + ((logPtr - 1) * SDI4FS_BLOCK_SIZE));
-    std::unique_ptr<DataBlock> newDataBlock(new DataBlock(dev));
-    // sanity
-    if (newDataBlock->getId() != id) {
-        std::cout << "fs: error - inconsistency, tried to load DataBlock " << id << ", but got " << newDataBlock->getId() << std::endl;
+    std::unique_ptr<DataBlock> newDataBlock = readBlock<DataBlock>(id, "DataBlock");
+    if (!newDataBlock) {
         return std::unique_ptr<DataBlock>(nullptr);
     }
     return newDataBlock;
 }
 
+bool FS::loadDataBlocks(File &file, uint32_t firstBlockNo, std::vector<std::unique_ptr<DataBlock>> &blocks) {
+    // (log position, index)
+    std::vector<std::pair<uint32_t, std::size_t>> order;
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        order.push_back(std::make_pair(lookupBlockAddress(file.getDataBlockID(firstBlockNo + i)), i));
+    }
+    std::sort(order.begin(), order.end());
+    for (auto &entry : order) {
+        blocks[entry.second] = loadDataBlock(file.getDataBlockID(firstBlockNo + entry.second));
+        if (!blocks[entry.second]) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void FS::reconstructBMap() {
+    // STEPS 1 + 2: find the latest instance of every block
+    if ((features & SDI4FS_FEATURE_OUT_OF_LINE_HEADERS) != 0) {
+        scanSummary();
+    } else {
+        scanLog();
+    }
+
+    // STEP 3: depth-first traversal, to filter out unreachable INodes/Blocks
+    bool *bmapFilter = new bool[logSize];
+    for (uint32_t i = 0; i < logSize; ++i) {
+        bmapFilter[i] = false;
+    }
+
+    std::unique_ptr<Directory> rootDir = loadDirectory(1);
+    recursiveRecovery(bmapFilter, *rootDir.get());
+
+    for (uint32_t i = 0; i < logSize; ++i) {
+        if (!bmapFilter[i]) {
+            // block not reachable, remove if previously found
+            if (loadBMapEntry(&bmap[i])) {
+                std::cout << "fs: unreachable block @ " << i << " removed from bmap" << std::endl;
+                storeBMapEntry(&bmap[i], 0);
+                setINodeType(i + 1, 0);
+                --usedBlocks;
+            }
+        }
+    }
+
+    delete bmapFilter;
+
+    // sanity checks for recovery results
+    if (usedBlocks == 0) {
+        std::cout << "fs: error - recovery failed, zero blocks found" << std::endl;
+    }
+}
+
+void FS::scanSummary() {
+    // every saved block instance has a unique sequence number, so the highest one wins, independent of the scan order
+    // this also yields exact values for both log heads, nextBlockID and the next sequence number
+    usedBlocks = 0;
+    nextBlockID = 0;
+    uint32_t lastWritePtr = 0;
+    uint32_t lastColdWritePtr = 0;
+    uint32_t latestWriteTime = 0;
+    uint64_t latestSequence = 0;
+    uint64_t latestColdSequence = 0;
+    std::vector<uint64_t> latestSequences(logSize, 0);
+    for (uint32_t i = 0; i < logSize; ++i) {
+        SummaryEntry &entry = getSummaryEntry(i + 1);
+        // valid block?
+        if (entry.id == 0) {
+            continue;
+        }
+        if (entry.id > logSize) {
+            std::cout << "fs: error - invalid blockID " << entry.id << " in summary of slot " << i + 1 << ", ignored" << std::endl;
+            continue;
+        }
+        bool cold = (entry.sequence & SDI4FS_SUMMARY_COLD_BIT) != 0;
+        uint64_t sequence = entry.sequence & ~SDI4FS_SUMMARY_COLD_BIT;
+        // first or newer instance
+        if (loadBMapEntry(&bmap[entry.id - 1]) == 0) {
+            ++usedBlocks;
+            storeBMapEntry(&bmap[entry.id - 1], i + 1);
+            latestSequences[entry.id - 1] = sequence;
+        } else if (sequence > latestSequences[entry.id - 1]) {
+            storeBMapEntry(&bmap[entry.id - 1], i + 1);
+            latestSequences[entry.id - 1] = sequence;
+        }
+        // latest write of each head
+        if (cold && sequence >= latestColdSequence) {
+            latestColdSequence = sequence;
+            lastColdWritePtr = i + 1;
+        } else if (!cold && sequence >= latestSequence) {
+            latestSequence = sequence;
+            lastWritePtr = i + 1;
+        }
+        if (entry.writeTime > latestWriteTime) {
+            latestWriteTime = entry.writeTime;
+        }
+        // biggest blockID (nextBlockID)
+        if (nextBlockID < entry.id) {
+            nextBlockID = entry.id;
+        }
+    }
+    ++nextBlockID;
+    nextSequence = std::max(latestSequence, latestColdSequence) + 1;
+    write_ptr = lastWritePtr + 1;
+    if (write_ptr > logSize) {
+        write_ptr = 1;
+    }
+    // without any cold block, the cold head keeps its value from the header
+    if (lastColdWritePtr != 0) {
+        coldWritePtr = lastColdWritePtr + 1;
+        if (coldWritePtr > logSize) {
+            coldWritePtr = 1;
+        }
+    }
+    std::cout << "fs: recovered " << usedBlocks << " blocks, nextBlockID: " << nextBlockID << ", write_ptr: " << write_ptr
+            << ", cold write_ptr: " << coldWritePtr << std::endl;
+
+#ifndef DEV_LINUX
+    // for systems without rtc
+    pseudoTime = latestWriteTime + 1;
+    std::cout << "fs: set next pseudo timestamp to " << pseudoTime << std::endl;
+#endif // DEV_LINUX
+}
+
+void FS::scanLog() {
     // STEP 1: reconstruct/estimate some header values:
     // - write_ptr (next write pos in log)
     // - nextBlockID
@@ -342,12 +602,10 @@ void FS::reconstructBMap() {
     uint32_t latestWriteTime = 0;
     nextBlockID = 0;
     for (uint32_t i = 0; i < logSize; ++i) {
-        // read block
-        dev.seekg(logStart_bptr + (i * SDI4FS_BLOCK_SIZE));
+        // read block header
         uint32_t id;
         uint32_t writeTime;
-        read32(dev, &id);
-        read32(dev, &writeTime);
+        readSlotHeader(i + 1, &id, &writeTime);
         // check valid, newer (write_ptr)
         if (id != 0 && writeTime >= latestWriteTime) {
             latestWriteTime = writeTime;
@@ -391,27 +649,24 @@ void FS::reconstructBMap() {
         if (j >= logSize) {
             j -= logSize;
         }
-        // read block
-        dev.seekg(logStart_bptr + (j * SDI4FS_BLOCK_SIZE));
         // read id, writeTime
         uint32_t id;
         uint32_t lastWriteTime;
-        read32(dev, &id);
-        read32(dev, &lastWriteTime);
+        readSlotHeader(j + 1, &id, &lastWriteTime);
         // valid block?
         if (id == 0) {
             continue;
         }
         std::cout << "fs: found block with id " << id << " at pos " << j + 1 << " writeTime " << lastWriteTime; // no std::endl
         // seen before?
-        if (bmap[id - 1] == 0) {
+        if (loadBMapEntry(&bmap[id - 1]) == 0) {
             ++usedBlocks;
         }
         // newer block (less *and* equal!)
         if (latestWriteTimes[id - 1] <= lastWriteTime) {
             std::cout << " -> saved" << std::endl;
             // put in bmap
-            bmap[id - 1] = j + 1;
+            storeBMapEntry(&bmap[id - 1], j + 1);
             latestWriteTimes[id - 1] = lastWriteTime;
         } else {
             std::cout << " -> outdated" << std::endl;
@@ -419,33 +674,6 @@ void FS::reconstructBMap() {
     }
 
     free(latestWriteTimes);
-
-    // STEP 3: depth-first traversal, to filter out unreachable INodes/Blocks
-    bool *bmapFilter = new bool[logSize];
-    for (uint32_t i = 0; i < logSize; ++i) {
-        bmapFilter[i] = false;
-    }
-
-    std::unique_ptr<Directory> rootDir = loadDirectory(1);
-    recursiveRecovery(bmapFilter, *rootDir.get());
-
-    for (uint32_t i = 0; i < logSize; ++i) {
-        if (!bmapFilter[i]) {
-            // block not reachable, remove if previously found
-            if (bmap[i]) {
-                std::cout << "fs: unreachable block @ " << i << " removed from bmap" << std::endl;
-                bmap[i] = 0;
-                --usedBlocks;
-            }
-        }
-    }
-
-    delete bmapFilter;
-
-    // sanity checks for recovery results
-    if (usedBlocks == 0) {
-        std::cout << "fs: error - recovery failed, zero blocks found" << std::endl;
-    }
 }
 
 void FS::recursiveRecovery(bool *bmapFilter, Directory &dir) {
@@ -472,10 +700,18 @@ void FS::recursiveRecovery(bool *bmapFilter, Directory &dir) {
                 recursiveRecovery(bmapFilter, *childDir.get());
                 break;
             case SDI4FS_INODE_TYPE_REGULARFILE:
+                // files with more than one hardlink are found more than once, count their blocks only once
+                if (bmapFilter[linkID - 1]) {
+                    break;
+                }
                 // load file, mark all blocks reachable
                 file = loadFile(linkID);
                 file->blocks(fileBlockIDs);
                 for (uint32_t blockID : fileBlockIDs) {
+                    if (bmapFilter[blockID - 1]) {
+                        // already reached through another file, only DataBlocks of clones are shared
+                        ++sharedBlocks[blockID];
+                    }
                     bmapFilter[blockID - 1] = true;
                 }
                 break;
@@ -497,7 +733,7 @@ void FS::initCallbacks() {
 
         virtual DirectoryEntryList* alloc() {
             // sanity check
-            if (fs->usedBlocks + 1 > fs->logSize) {
+            if (!fs->hasFreeBlocks(1)) {
                 // should never happen, FS checks free space before calling methods in dir object
                 std::cout << "fs: cannot create new DirEntryList, fs is full" << std::endl;
                 return NULL;
@@ -529,13 +765,14 @@ void FS::initCallbacks() {
         }
 
         virtual DataBlockList* alloc() {
-            // sanity check
-            if (fs->usedBlocks + 1 > fs->logSize) {
+            // the caller reserved the slot (see reserveBlocks), only an id is required
+            uint32_t id = fs->getNextBlockID();
+            if (id == 0) {
                 // full, user will have to stop writing to this file
                 return NULL;
             }
             // alloc
-            DataBlockList *newDataBlockList = new DataBlockList(fs->getNextBlockID());
+            DataBlockList *newDataBlockList = new DataBlockList(id);
             // do *not* store, this is the responsibility of the file object
             return newDataBlockList;
         }
@@ -553,20 +790,24 @@ void FS::initCallbacks() {
     dataBlockListCreator = new DataBlockListCreator(this);
 }
 
-bool FS::mkdir(std::string absolutePath) {
-    absolutePath = normalizePath(absolutePath);
-    if (absolutePath.find_first_of("/") != 0) {
-        // not an absolute path
-        std::cout << "fs: mkdir: cannot create dir with path \"" << absolutePath << "\", path is not absolute" << std::endl;
+bool FS::mkdir(PathView absolutePath) {
+    if (rejectReadOnly("mkdir")) {
+        return false;
+    }
+    std::lock_guard<RWLock> fsGuard(fsLock);
+    ResolvedPath path;
+    if (!path.parse(absolutePath) || path.isRoot()) {
+        // not an absolute path, or no name given
+        std::cout << "fs: mkdir: cannot create dir with path \"" << absolutePath << "\", invalid path" << std::endl;
         return false;
     }
     // this requires at least 4 free blocks (1 for new dir, 1 for updated parent, (rare:) 2 for parent switching from inline to non-inline)
-    if (usedBlocks + 4 > logSize) {
+    if (!hasFreeBlocks(4)) {
         std::cout << "fs: mkdir: cannot create new directory, fs is full" << std::endl;
         return false;
     }
     // find parent node
-    std::unique_ptr<Directory> parent = searchParent(absolutePath);
+    std::unique_ptr<Directory> parent = searchParent(path);
     // parent exists?
     if (!parent) {
         std::cout << "fs: mkdir: cannot create dir with path \"" << absolutePath << "\", parent does not exist" << std::endl;
@@ -574,7 +815,7 @@ bool FS::mkdir(std::string absolutePath) {
     }
 
     // child already existing?
-    if (parent->searchHardlink(lastName(absolutePath)) != 0) {
+    if (parent->searchHardlink(path.lastName()) != 0) {
         std::cout << "fs: mkdir: cannot create dir with path \"" << absolutePath << "\", dir exists" << std::endl;
         return false;
     }
@@ -594,10 +835,14 @@ bool FS::mkdir(std::string absolutePath) {
     uint32_t newBlockID = getNextBlockID();
     // alloc new block
     std::unique_ptr<DirectoryINode> newDirINode(new DirectoryINode(newBlockID));
+    {
+        std::lock_guard<std::mutex> devGuard(devLock);
+        setINodeType(newBlockID, SDI4FS_INODE_TYPE_DIR);
+    }
     // create directory object for it
     std::unique_ptr<Directory> newDir(new Directory(dirEntryListCreator, std::move(newDirINode), parent));
     // create link from parent to new child (this cannot overflow the link counter in the child since it is brand new)
-    std::list<Block*> changedBlocks = parent->addHardlink(newDir->getPrimaryINode(), lastName(absolutePath));
+    std::list<Block*> changedBlocks = parent->addHardlink(newDir->getPrimaryINode(), path.lastName());
     // save
     for (auto &block : changedBlocks) {
         saveBlock(*block);
@@ -607,27 +852,31 @@ bool FS::mkdir(std::string absolutePath) {
     return true;
 }
 
-bool FS::rmdir(std::string absolutePath) {
-    absolutePath = normalizePath(absolutePath);
-    if (absolutePath.find_first_of("/") != 0) {
-        // not an absolute path
-        std::cout << "fs: rmdir: cannot remove dir with path \"" << absolutePath << "\", path is not absolute" << std::endl;
+bool FS::rmdir(PathView absolutePath) {
+    if (rejectReadOnly("rmdir")) {
+        return false;
+    }
+    std::lock_guard<RWLock> fsGuard(fsLock);
+    ResolvedPath path;
+    if (!path.parse(absolutePath) || path.isRoot()) {
+        // not an absolute path, or no name given
+        std::cout << "fs: rmdir: cannot remove dir with path \"" << absolutePath << "\", invalid path" << std::endl;
         return false;
     }
     // this is a bit counter-intuitive, but removing a dir requires up to 2 blocks (for re-writing the list in parent, child or both)
-    if (usedBlocks + 2 > logSize) {
+    if (!hasFreeBlocks(2)) {
         std::cout << "fs: rmdir: cannot remove directory, fs is full (2 blocks buffer required)" << std::endl;
         return false;
     }
     // find parent node
-    std::unique_ptr<Directory> parent = searchParent(absolutePath);
+    std::unique_ptr<Directory> parent = searchParent(path);
     // parent exists?
     if (!parent) {
         std::cout << "fs: rmdir: cannot remove dir with path \"" << absolutePath << "\", parent does not exist" << std::endl;
         return false;
     }
     // dir exists?
-    uint32_t id = parent->searchHardlink(lastName(absolutePath));
+    uint32_t id = parent->searchHardlink(path.lastName());
     if (id == 0) {
         std::cout << "fs: rmdir: cannot remove dir with path \"" << absolutePath << "\", dir does not exist" << std::endl;
         return false;
@@ -655,7 +904,7 @@ bool FS::rmdir(std::string absolutePath) {
     }
 
     // all requirements ok, delete hardlink from parent
-    std::list<Block*> changedBlocks = parent->rmHardlink(dir->getPrimaryINode(), lastName(absolutePath));
+    std::list<Block*> changedBlocks = parent->rmHardlink(dir->getPrimaryINode(), path.lastName());
     // delete ".." link from child, since it affects parents link counter
     addUnique<Block*>(changedBlocks, dir->rmHardlink(parent->getPrimaryINode(), ".."));
     for (auto &block : changedBlocks) {
@@ -679,44 +928,48 @@ bool FS::rmdir(std::string absolutePath) {
     return true;
 }
 
-bool FS::rename(std::string sourcePath, std::string destPath) {
-    sourcePath = normalizePath(sourcePath);
-    destPath = normalizePath(destPath);
-    if (sourcePath.find_first_of("/") != 0 || destPath.find_first_of("/") != 0) {
-        // not an absolute path
-        std::cout << "fs: rename: cannot rename from path \"" << sourcePath << "\" to \"" << destPath << "\", both paths must be absolute" << std::endl;
+bool FS::rename(PathView sourcePath, PathView destPath) {
+    if (rejectReadOnly("rename")) {
+        return false;
+    }
+    std::lock_guard<RWLock> fsGuard(fsLock);
+    ResolvedPath source;
+    ResolvedPath dest;
+    if (!source.parse(sourcePath) || !dest.parse(destPath) || source.isRoot() || dest.isRoot()) {
+        // not an absolute path, or no name given
+        std::cout << "fs: rename: cannot rename from path \"" << sourcePath << "\" to \"" << destPath << "\", both paths must be absolute and must not be the root dir" << std::endl;
         return false;
     }
     // rename requires up to 5 blocks (up to 2 to rm in old, up to 3 for new hardlink)
-    if (usedBlocks + 5 > logSize) {
+    if (!hasFreeBlocks(5)) {
         std::cout << "fs: rename: cannot rename, fs is full (5 blocks buffer required)" << std::endl;
         return false;
     }
 
     // new link cannot be child of current link
-    if (destPath.find(sourcePath) == 0 && destPath.length() > sourcePath.length()) {
+    if (source.isAncestorOf(dest)) {
         std::cout << "fs: rename: cannot rename, new path cannot be child of old" << std::endl;
         return false;
     }
 
     // check old hardlink exists
-    std::unique_ptr<Directory> oldParent = searchParent(sourcePath);
+    std::unique_ptr<Directory> oldParent = searchParent(source);
     if (!oldParent) {
         std::cout << "fs: rename: cannot rename, parent of source path \"" << sourcePath << "\" does not exist" << std::endl;
         return false;
     }
-    int targetID = oldParent->searchHardlink(lastName(sourcePath));
+    int targetID = oldParent->searchHardlink(source.lastName());
     if (targetID == 0) {
         std::cout << "fs: rename: cannot rename, source path \"" << sourcePath << "\" does not exist" << std::endl;
         return false;
     }
     // check parent of new hardlink exists, but hardlink itself not
-    std::unique_ptr<Directory> newParent = searchParent(destPath);
+    std::unique_ptr<Directory> newParent = searchParent(dest);
     if (!newParent) {
         std::cout << "fs: rename: cannot rename, parent of dest path \"" << destPath << "\" does not exist" << std::endl;
         return false;
     }
-    if (newParent->searchHardlink(lastName(destPath))) {
+    if (newParent->searchHardlink(dest.lastName())) {
         std::cout << "fs: rename: cannot rename, target \"" << destPath << "\" exists" << std::endl;
         return false;
     }
@@ -742,8 +995,8 @@ bool FS::rename(std::string sourcePath, std::string destPath) {
         // same dir
         // beware: there are now 2 directory objects for the same dir!
         // from this point on, only oldParent is used!
-        std::list<Block*> changes = oldParent->rmHardlink(moveTarget->getPrimaryINode(), lastName(sourcePath));
-        addUnique<Block*>(changes, oldParent->addHardlink(moveTarget->getPrimaryINode(), lastName(destPath)));
+        std::list<Block*> changes = oldParent->rmHardlink(moveTarget->getPrimaryINode(), source.lastName());
+        addUnique<Block*>(changes, oldParent->addHardlink(moveTarget->getPrimaryINode(), dest.lastName()));
         // save all returned dirs
         for (Block *block : changes) {
             saveBlock(*block);
@@ -761,8 +1014,8 @@ bool FS::rename(std::string sourcePath, std::string destPath) {
             return false;
         }
         // move target
-        std::list<Block*> changes = oldParent->rmHardlink(moveTarget->getPrimaryINode(), lastName(sourcePath));
-        addUnique<Block*>(changes, newParent->addHardlink(moveTarget->getPrimaryINode(), lastName(destPath)));
+        std::list<Block*> changes = oldParent->rmHardlink(moveTarget->getPrimaryINode(), source.lastName());
+        addUnique<Block*>(changes, newParent->addHardlink(moveTarget->getPrimaryINode(), dest.lastName()));
         if (directory) {
             // also need to take care of ".." link
             addUnique<Block*>(changes, static_cast<Directory*> (moveTarget.get())->rmHardlink(oldParent->getPrimaryINode(), ".."));
@@ -777,20 +1030,24 @@ bool FS::rename(std::string sourcePath, std::string destPath) {
     return true;
 }
 
-bool FS::touch(std::string absolutePath) {
-    absolutePath = normalizePath(absolutePath);
-    if (absolutePath.find_first_of("/") != 0) {
-        // not an absolute path
-        std::cout << "fs: touch: cannot create file with path \"" << absolutePath << "\", path is not absolute" << std::endl;
+bool FS::touch(PathView absolutePath) {
+    if (rejectReadOnly("touch")) {
+        return false;
+    }
+    std::lock_guard<RWLock> fsGuard(fsLock);
+    ResolvedPath path;
+    if (!path.parse(absolutePath) || path.isRoot()) {
+        // not an absolute path, or no name given
+        std::cout << "fs: touch: cannot create file with path \"" << absolutePath << "\", invalid path" << std::endl;
         return false;
     }
     // this requires at least 4 free blocks (1 for new file, 1 for updated parent, (rare:) 2 for parent switching from inline to non-inline)
-    if (usedBlocks + 4 > logSize) {
+    if (!hasFreeBlocks(4)) {
         std::cout << "fs: touch: cannot create new file, fs is full" << std::endl;
         return false;
     }
     // find parent node
-    std::unique_ptr<Directory> parent = searchParent(absolutePath);
+    std::unique_ptr<Directory> parent = searchParent(path);
     // parent exists?
     if (!parent) {
         std::cout << "fs: touch: cannot create file with path \"" << absolutePath << "\", parent does not exist" << std::endl;
@@ -798,7 +1055,7 @@ bool FS::touch(std::string absolutePath) {
     }
 
     // child already existing?
-    if (parent->searchHardlink(lastName(absolutePath)) != 0) {
+    if (parent->searchHardlink(path.lastName()) != 0) {
         std::cout << "fs: touch: cannot create file with path \"" << absolutePath << "\", file exists" << std::endl;
         return false;
     }
@@ -813,10 +1070,14 @@ bool FS::touch(std::string absolutePath) {
     uint32_t newBlockID = getNextBlockID();
     // alloc new block
     std::unique_ptr<FileINode> newFileINode(new FileINode(newBlockID));
+    {
+        std::lock_guard<std::mutex> devGuard(devLock);
+        setINodeType(newBlockID, SDI4FS_INODE_TYPE_REGULARFILE);
+    }
     // create file object for it
     std::unique_ptr<File> newFile(new File(dataBlockListCreator, std::move(newFileINode)));
     // create link from parent to new child (cannot overflow child link counter since child is brand new)
-    std::list<Block*> changedBlocks = parent->addHardlink(newFile->getPrimaryINode(), lastName(absolutePath));
+    std::list<Block*> changedBlocks = parent->addHardlink(newFile->getPrimaryINode(), path.lastName());
     // save
     for (auto &block : changedBlocks) {
         saveBlock(*block);
@@ -826,106 +1087,264 @@ bool FS::touch(std::string absolutePath) {
     return true;
 }
 
-bool FS::ls(std::string absolutePath, std::list<std::string> &result) {
-    absolutePath = normalizePath(absolutePath);
-    if (absolutePath.find_first_of("/") != 0) {
-        // not an absolute path
-        std::cout << "fs: ls: cannot list dir with path \"" << absolutePath << "\", path is not absolute" << std::endl;
+bool FS::ls(PathView absolutePath, std::list<std::string> &result) {
+    SharedLockGuard fsGuard(fsLock);
+    ReaddirCursor cursor;
+    if (!openDirImpl(absolutePath, cursor)) {
+        // openDir already printed the reason
+        std::cout << "fs: ls: cannot list dir with path \"" << absolutePath << "\"" << std::endl;
         return false;
     }
-    // find parent node
-    std::unique_ptr<Directory> parent = searchParent(absolutePath);
-    // parent exists?
-    if (!parent) {
-        std::cout << "fs: ls: cannot list dir with path \"" << absolutePath << "\", parent does not exist" << std::endl;
+    std::vector<DirEntry> batch;
+    while (!cursor.isAtEnd()) {
+        if (!readdirImpl(cursor, batch, SDI4FS_MAX_LINKS_PER_DIRENTRYLIST, true)) {
+            return false;
+        }
+        for (DirEntry &entry : batch) {
+            // output format: TYPE (d/f) SIZE SIZE_ON_DISK T_CREATED T_MODIFIED
+            std::stringstream ss;
+            switch (entry.type) {
+                case SDI4FS_INODE_TYPE_DIR:
+                    ss << "d ";
+                    break;
+                case SDI4FS_INODE_TYPE_REGULARFILE:
+                    ss << "f ";
+                    break;
+                default:
+                    std::cout << "fs: ls: cannot list child with unknown INode type " << (int) entry.type << std::endl;
+                    continue;
+            }
+            ss << entry.stat.linkCounter << " ";
+            ss << entry.stat.size_b << " ";
+            ss << entry.stat.diskSize_b << " ";
+            ss << entry.stat.creationTime << " ";
+            ss << entry.stat.lastWriteTime << " ";
+            ss << entry.name;
+            result.push_back(ss.str());
+        }
+    }
+    // header if not empty
+    if (!result.empty()) {
+        result.push_front("t #links size disksize t_created t_mod name");
+    }
+    return true;
+}
+
+bool FS::openDir(PathView absolutePath, ReaddirCursor &cursor) {
+    SharedLockGuard fsGuard(fsLock);
+    return openDirImpl(absolutePath, cursor);
+}
+
+bool FS::openDirImpl(PathView absolutePath, ReaddirCursor &cursor) {
+    ResolvedPath path;
+    if (!path.parse(absolutePath)) {
+        // not an absolute path
+        std::cout << "fs: openDir: cannot open dir with path \"" << absolutePath << "\", invalid path" << std::endl;
         return false;
     }
     uint32_t id = 1; // default to root
     // root dir is its own parent
-    if (absolutePath.compare("/") != 0) {
+    if (!path.isRoot()) {
+        // find parent node
+        std::unique_ptr<Directory> parent = searchParent(path);
+        // parent exists?
+        if (!parent) {
+            std::cout << "fs: openDir: cannot open dir with path \"" << absolutePath << "\", parent does not exist" << std::endl;
+            return false;
+        }
         // dir exists?
-        id = parent->searchHardlink(lastName(absolutePath));
+        id = parent->searchHardlink(path.lastName());
         if (id == 0) {
-            std::cout << "fs: ls: cannot list dir with path \"" << absolutePath << "\", dir does not exist" << std::endl;
+            std::cout << "fs: openDir: cannot open dir with path \"" << absolutePath << "\", dir does not exist" << std::endl;
             return false;
         }
         // is this even a dir?
         if (peekINodeType(id) != SDI4FS_INODE_TYPE_DIR) {
-            std::cout << "fs: ls: cannot list dir with path \"" << absolutePath << "\", not a directory" << std::endl;
+            std::cout << "fs: openDir: cannot open dir with path \"" << absolutePath << "\", not a directory" << std::endl;
             return false;
         }
     }
-    // load dir
-    std::unique_ptr<Directory> dir = loadDirectory(id);
-    if (!dir) {
-        // should never happen
-        std::cout << "fs: fatal error - inconsistency - unable to load dir with primary inode id " << id << std::endl;
-        return false;
-    }
-    // get content, then augment
-    std::list<std::string> list;
-    dir->ls(list);
-    for (std::string linkName : list) {
-        // try accessing the child
-        uint32_t childID = dir->searchHardlink(linkName);
-        std::unique_ptr<IPrimaryINodeHolder> child;
-        bool directory = false;
-        switch (peekINodeType(childID)) {
-            case SDI4FS_INODE_TYPE_DIR:
-                child = std::move(loadDirectory(childID));
-                directory = true;
-                break;
-            case SDI4FS_INODE_TYPE_REGULARFILE:
-                child = std::move(loadFile(childID));
-                break;
-            default:
-                std::cout << "fs: ls: cannot list child with unknown INode type " << peekINodeType(childID) << std::endl;
-                continue;
-        }
-        INode *childINode = &child->getPrimaryINode();
-        // output format: TYPE (d/f) SIZE SIZE_ON_DISK T_CREATED T_MODIFIED
-        std::stringstream ss;
-        if (directory) {
-            ss << "d ";
-        } else {
-            ss << "f ";
-        }
-        ss << childINode->getLinkCounter() << " ";
-        ss << childINode->getInternalSize_b() << " ";
-        ss << childINode->getUserVisibleSize_b() << " ";
-        ss << childINode->getCreationTime() << " ";
-        ss << childINode->getLastWriteTime() << " ";
-        ss << linkName;
-        result.push_back(ss.str());
-    }
-    // header if not empty
-    if (!list.empty()) {
-        result.push_front("t #links size disksize t_created t_mod name");
-    }
+    cursor.dirID = id;
+    cursor.listID = 0;
+    cursor.lastName[0] = 0;
+    cursor.end = false;
     return true;
 }
 
-bool FS::rm(std::string absolutePath) {
-    absolutePath = normalizePath(absolutePath);
-    if (absolutePath.find_first_of("/") != 0) {
-        // not an absolute path
-        std::cout << "fs: rm: cannot remove file with path \"" << absolutePath << "\", path is not absolute" << std::endl;
-        return false;
-    }
-    // this is a bit counter-intuitive, but removing a file requires up to 2 free block (for re-writing the parent)
-    if (usedBlocks + 2 > logSize) {
-        std::cout << "fs: rm: cannot remove file, fs is full (2 blocks buffer required)" << std::endl;
-        return false;
+bool FS::readdir(ReaddirCursor &cursor, std::vector<DirEntry> &batch, std::size_t maxEntries) {
+    SharedLockGuard fsGuard(fsLock);
+    return readdirImpl(cursor, batch, maxEntries, false);
+}
+
+bool FS::readdirplus(ReaddirCursor &cursor, std::vector<DirEntry> &batch, std::size_t maxEntries) {
+    SharedLockGuard fsGuard(fsLock);
+    return readdirImpl(cursor, batch, maxEntries, true);
+}
+
+namespace {
+
+/**
+ * Orders hardlinks by name, names are unique within a directory.
+ */
+bool linkNameLess(const Hardlink *a, const Hardlink *b) {
+    return a->getLinkName() < b->getLinkName();
+}
+
+/**
+ * Returns the smallest DirectoryEntryList id that is not smaller than the given one.
+ * @param listIDs the lists of a directory, in any order
+ * @param min the lower bound
+ * @return the id, zero if there is none
+ */
+uint32_t nextDirEntryListID(const std::list<uint32_t> &listIDs, uint32_t min) {
+    uint32_t next = 0;
+    for (uint32_t id : listIDs) {
+        if (id >= min && (next == 0 || id < next)) {
+            next = id;
+        }
+    }
+    return next;
+}
+
+} // anonymous namespace
+
+bool FS::readdirImpl(ReaddirCursor &cursor, std::vector<DirEntry> &batch, std::size_t maxEntries, bool withStat) {
+    batch.clear();
+    if (cursor.end) {
+        // nothing left (or never opened)
+        return true;
+    }
+    if (maxEntries == 0) {
+        std::cout << "fs: readdir: batch size must not be zero" << std::endl;
+        return false;
+    }
+    // only the primary INode, the lists are loaded one by one below
+    std::unique_ptr<DirectoryINode> inode = loadDirectoryINode(cursor.dirID);
+    if (!inode) {
+        // deleted since openDir
+        std::cout << "fs: readdir: cannot read dir " << cursor.dirID << ", not found" << std::endl;
+        return false;
+    }
+    std::vector<const Hardlink*> links;
+    bool complete;
+    if (inode->isInlined()) {
+        for (uint32_t i = 0; i < inode->getNumberOfHardlinks(); ++i) {
+            links.push_back(&inode->getLink(i));
+        }
+        if (!appendDirEntries(links, cursor, batch, maxEntries, withStat, &complete)) {
+            return false;
+        }
+        cursor.end = complete;
+        return true;
+    }
+    const std::list<uint32_t> &listIDs = inode->getDirEntryListIDs();
+    if (cursor.listID == 0 && cursor.lastName[0] != 0 && !listIDs.empty()) {
+        // started while inlined, the returned entries were moved to the first list by the conversion
+        // (lists with smaller ids were created afterwards and only hold new entries)
+        cursor.listID = listIDs.front();
+    }
+    while (true) {
+        // a removed list is simply skipped, the ids of the others do not change
+        uint32_t listID = nextDirEntryListID(listIDs, cursor.listID);
+        if (listID == 0) {
+            cursor.end = true;
+            return true;
+        }
+        if (batch.size() == maxEntries) {
+            return true;
+        }
+        if (listID != cursor.listID) {
+            cursor.listID = listID;
+            cursor.lastName[0] = 0;
+        }
+        std::unique_ptr<DirectoryEntryList> list = loadDirEntryList(listID);
+        if (!list) {
+            std::cout << "fs: readdir: unable to read dir " << cursor.dirID << ", requested dirEntryList " << listID << " not found" << std::endl;
+            return false;
+        }
+        links.clear();
+        for (uint32_t i = 0; i < list->getNumberOfHardlinks(); ++i) {
+            links.push_back(&list->getLink(i));
+        }
+        if (!appendDirEntries(links, cursor, batch, maxEntries, withStat, &complete)) {
+            return false;
+        }
+        if (!complete) {
+            // batch full, continue within this list next time
+            return true;
+        }
+        // list done
+        ++cursor.listID;
+        cursor.lastName[0] = 0;
+    }
+}
+
+bool FS::appendDirEntries(std::vector<const Hardlink*> &links, ReaddirCursor &cursor, std::vector<DirEntry> &batch, std::size_t maxEntries, bool withStat, bool *complete) {
+    // only the names after the last returned one, removals in between do not matter
+    PathView lastName(cursor.lastName);
+    std::vector<const Hardlink*> next;
+    for (const Hardlink *link : links) {
+        if (lastName < link->getLinkName()) {
+            next.push_back(link);
+        }
+    }
+    std::sort(next.begin(), next.end(), linkNameLess);
+    std::size_t n = std::min(next.size(), maxEntries - batch.size());
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!appendDirEntry(*next[i], batch, withStat)) {
+            return false;
+        }
+    }
+    if (n != 0) {
+        PathView name = next[n - 1]->getLinkName();
+        memcpy(cursor.lastName, name.data(), name.size());
+        cursor.lastName[name.size()] = 0;
+    }
+    *complete = n == next.size();
+    return true;
+}
+
+bool FS::appendDirEntry(const Hardlink &link, std::vector<DirEntry> &batch, bool withStat) {
+    batch.emplace_back();
+    DirEntry &entry = batch.back();
+    PathView name = link.getLinkName();
+    memcpy(entry.name, name.data(), name.size());
+    entry.name[name.size()] = 0;
+    entry.id = link.getTarget();
+    entry.type = peekINodeType(entry.id);
+    entry.stat = StatInfo();
+    if (!withStat || (entry.type != SDI4FS_INODE_TYPE_DIR && entry.type != SDI4FS_INODE_TYPE_REGULARFILE)) {
+        // not requested, or unknown type (leave stat empty)
+        return true;
+    }
+    return statByIdImpl(entry.id, entry.stat);
+}
+
+bool FS::rm(PathView absolutePath) {
+    if (rejectReadOnly("rm")) {
+        return false;
+    }
+    std::lock_guard<RWLock> fsGuard(fsLock);
+    ResolvedPath path;
+    if (!path.parse(absolutePath) || path.isRoot()) {
+        // not an absolute path, or no name given
+        std::cout << "fs: rm: cannot remove file with path \"" << absolutePath << "\", invalid path" << std::endl;
+        return false;
+    }
+    // this is a bit counter-intuitive, but removing a file requires up to 2 free block (for re-writing the parent)
+    if (!hasFreeBlocks(2)) {
+        std::cout << "fs: rm: cannot remove file, fs is full (2 blocks buffer required)" << std::endl;
+        return false;
     }
     // find parent node
-    std::unique_ptr<Directory> parent = searchParent(absolutePath);
+    std::unique_ptr<Directory> parent = searchParent(path);
     // parent exists?
     if (!parent) {
         std::cout << "fs: rm: cannot remove file with path \"" << absolutePath << "\", parent does not exist" << std::endl;
         return false;
     }
     // file exists?
-    uint32_t id = parent->searchHardlink(lastName(absolutePath));
+    uint32_t id = parent->searchHardlink(path.lastName());
     if (id == 0) {
         std::cout << "fs: rm: cannot remove file with path \"" << absolutePath << "\", file does not exist" << std::endl;
         return false;
@@ -944,7 +1363,7 @@ bool FS::rm(std::string absolutePath) {
     }
 
     // all requirements ok, delete hardlink from parent
-    std::list<Block*> changedBlocks = parent->rmHardlink(file->getPrimaryINode(), lastName(absolutePath));
+    std::list<Block*> changedBlocks = parent->rmHardlink(file->getPrimaryINode(), path.lastName());
     // save changes to parent
     for (auto &block : changedBlocks) {
         saveBlock(*block);
@@ -956,28 +1375,33 @@ bool FS::rm(std::string absolutePath) {
         std::list<uint32_t> blocks;
         file->blocks(blocks);
         for (uint32_t id : blocks) {
-            freeBlock(id);
+            // DataBlocks may still be used by clones
+            releaseBlock(id);
         }
     }
 
     return true;
 }
 
-bool FS::link(std::string sourcePath, std::string targetPath) {
-    sourcePath = normalizePath(sourcePath);
-    targetPath = normalizePath(targetPath);
-    if (sourcePath.find_first_of("/") != 0 || targetPath.find_first_of("/") != 0) {
-        // not an absolute path
-        std::cout << "fs: link: cannot link from path \"" << sourcePath << "\" to \"" << targetPath << "\", both paths must be absolute" << std::endl;
+bool FS::link(PathView sourcePath, PathView targetPath) {
+    if (rejectReadOnly("link")) {
+        return false;
+    }
+    std::lock_guard<RWLock> fsGuard(fsLock);
+    ResolvedPath source;
+    ResolvedPath target;
+    if (!source.parse(sourcePath) || !target.parse(targetPath) || source.isRoot() || target.isRoot()) {
+        // not an absolute path, or no name given
+        std::cout << "fs: link: cannot link from path \"" << sourcePath << "\" to \"" << targetPath << "\", both paths must be absolute and must not be the root dir" << std::endl;
         return false;
     }
     // link requires up to 3 new/buffer blocks (all in link parent)
-    if (usedBlocks + 3 > logSize) {
+    if (!hasFreeBlocks(3)) {
         std::cout << "fs: link: cannot create link, fs is full (3 blocks buffer required)" << std::endl;
         return false;
     }
     // find parent node of future link
-    std::unique_ptr<Directory> parent = searchParent(sourcePath);
+    std::unique_ptr<Directory> parent = searchParent(source);
     // parent exists?
     if (!parent) {
         std::cout << "fs: link: cannot create link with path \"" << sourcePath << "\", parent does not exist" << std::endl;
@@ -985,7 +1409,7 @@ bool FS::link(std::string sourcePath, std::string targetPath) {
     }
 
     // child already existing?
-    if (parent->searchHardlink(lastName(sourcePath)) != 0) {
+    if (parent->searchHardlink(source.lastName()) != 0) {
         std::cout << "fs: link: cannot create link with path \"" << sourcePath << "\", file exists" << std::endl;
         return false;
     }
@@ -996,14 +1420,14 @@ bool FS::link(std::string sourcePath, std::string targetPath) {
         return false;
     }
     // now find target
-    std::unique_ptr<Directory> targetParent = searchParent(targetPath); // this may now exist more than once, changes are strictly forbidden!
+    std::unique_ptr<Directory> targetParent = searchParent(target); // this may now exist more than once, changes are strictly forbidden!
     // parent exists?
     if (!targetParent) {
         std::cout << "fs: link: cannot create link with target \"" << targetPath << "\", parent does not exist" << std::endl;
         return false;
     }
     // target must exist
-    uint32_t targetID = parent->searchHardlink(lastName(targetPath));
+    uint32_t targetID = targetParent->searchHardlink(target.lastName());
     if (targetID == 0) {
         std::cout << "fs: link: cannot create link with target \"" << targetPath << "\", file does not exist" << std::endl;
         return false;
@@ -1020,60 +1444,251 @@ bool FS::link(std::string sourcePath, std::string targetPath) {
         return false;
     }
     // now finally add the link
-    std::list<Block*> changedBlocks = parent->addHardlink(file->getPrimaryINode(), lastName(sourcePath));
+    std::list<Block*> changedBlocks = parent->addHardlink(file->getPrimaryINode(), source.lastName());
+    for (Block *block : changedBlocks) {
+        saveBlock(*block);
+    }
+    return true;
+}
+
+bool FS::clone(PathView sourcePath, PathView targetPath) {
+    if (rejectReadOnly("clone")) {
+        return false;
+    }
+    std::lock_guard<RWLock> fsGuard(fsLock);
+    ResolvedPath source;
+    ResolvedPath target;
+    if (!source.parse(sourcePath) || !target.parse(targetPath) || source.isRoot() || target.isRoot()) {
+        // not an absolute path, or no name given
+        std::cout << "fs: clone: cannot clone from path \"" << sourcePath << "\" to \"" << targetPath << "\", both paths must be absolute and must not be the root dir" << std::endl;
+        return false;
+    }
+    // find source
+    std::unique_ptr<Directory> sourceParent = searchParent(source);
+    if (!sourceParent) {
+        std::cout << "fs: clone: cannot clone \"" << sourcePath << "\", parent does not exist" << std::endl;
+        return false;
+    }
+    uint32_t sourceID = sourceParent->searchHardlink(source.lastName());
+    if (sourceID == 0) {
+        std::cout << "fs: clone: cannot clone \"" << sourcePath << "\", file does not exist" << std::endl;
+        return false;
+    }
+    if (peekINodeType(sourceID) != SDI4FS_INODE_TYPE_REGULARFILE) {
+        std::cout << "fs: clone: cannot clone \"" << sourcePath << "\", not a file" << std::endl;
+        return false;
+    }
+    // the clone must see all completed writes
+    auto openIter = openFiles.find(sourceID);
+    if (openIter != openFiles.end()) {
+        flushFileImpl(*openIter->second);
+    }
+    std::unique_ptr<File> sourceFile = loadFile(sourceID);
+    if (!sourceFile) {
+        // should never happen
+        std::cout << "fs: fatal error - inconsistency - unable to load file with primary inode id " << sourceID << std::endl;
+        return false;
+    }
+    // 1 new FileINode, 1 new DataBlockList per list of the source (extents are part of the INode), up to 3 for the parent (see touch)
+    if (!hasFreeBlocks(4 + sourceFile->getNumberOfDataBlockLists())) {
+        std::cout << "fs: clone: cannot create clone, fs is full" << std::endl;
+        return false;
+    }
+    // find parent of the clone
+    std::unique_ptr<Directory> parent = searchParent(target);
+    if (!parent) {
+        std::cout << "fs: clone: cannot create file with path \"" << targetPath << "\", parent does not exist" << std::endl;
+        return false;
+    }
+    if (parent->searchHardlink(target.lastName()) != 0) {
+        std::cout << "fs: clone: cannot create file with path \"" << targetPath << "\", file exists" << std::endl;
+        return false;
+    }
+    if (parent->getChildCount() == SDI4FS_MAX_HARDLINKS_PER_DIR) {
+        std::cout << "fs: clone: cannot create new file, max # of links in parent dir reached, parent " << parent->getPrimaryINode().getId() << std::endl;
+        return false;
+    }
+
+    // create the clone
+    uint32_t newBlockID = getNextBlockID();
+    std::unique_ptr<FileINode> newFileINode(new FileINode(newBlockID));
+    {
+        std::lock_guard<std::mutex> devGuard(devLock);
+        setINodeType(newBlockID, SDI4FS_INODE_TYPE_REGULARFILE);
+    }
+    std::unique_ptr<File> newFile(new File(dataBlockListCreator, std::move(newFileINode)));
+    std::list<Block*> changedBlocks = newFile->cloneFrom(*sourceFile.get());
+    // every DataBlock now has one more reference
+    for (uint32_t i = 0; i < sourceFile->getNumberOfDataBlocks(); ++i) {
+        shareBlock(sourceFile->getDataBlockID(i));
+    }
+    // link (cannot overflow child link counter since child is brand new)
+    addUnique<Block*>(changedBlocks, parent->addHardlink(newFile->getPrimaryINode(), target.lastName()));
     for (Block *block : changedBlocks) {
         saveBlock(*block);
     }
     return true;
 }
 
-uint32_t FS::gc() {
+FS::SummaryEntry& FS::getSummaryEntry(uint32_t slot) {
+    uint32_t segment = (slot - 1) / SDI4FS_SLOTS_PER_SEGMENT;
+    if (segment != summaryCacheSegment) {
+        // one read for the whole segment
+        dev.seekg(summaryStart_bptr + (static_cast<uint64_t> (segment) * SDI4FS_BLOCK_SIZE));
+        readN(dev, &summaryCache[0], sizeof (summaryCache));
+        summaryCacheSegment = segment;
+    }
+    return summaryCache[(slot - 1) % SDI4FS_SLOTS_PER_SEGMENT];
+}
+
+void FS::readSlotHeader(uint32_t slot, uint32_t *id, uint32_t *writeTime) {
+    if ((features & SDI4FS_FEATURE_OUT_OF_LINE_HEADERS) != 0) {
+        SummaryEntry &entry = getSummaryEntry(slot);
+        *id = entry.id;
+        *writeTime = entry.writeTime;
+        return;
+    }
+    dev.seekg(logStart_bptr + (static_cast<uint64_t> (slot - 1) * SDI4FS_BLOCK_SIZE));
+    read32(dev, id);
+    read32(dev, writeTime);
+}
+
+void FS::clearSlot(uint32_t slot) {
+    if ((features & SDI4FS_FEATURE_OUT_OF_LINE_HEADERS) != 0) {
+        getSummaryEntry(slot).id = 0;
+        dev.seekp(summaryStart_bptr + (static_cast<uint64_t> (slot - 1) * SDI4FS_SUMMARY_ENTRY_SIZE));
+    } else {
+        dev.seekp(logStart_bptr + (static_cast<uint64_t> (slot - 1) * SDI4FS_BLOCK_SIZE));
+    }
+    write32(dev, 0);
+}
+
+void FS::writeSummaryEntry(uint32_t slot, Block &block, bool cold, bool continued) {
+    if ((features & SDI4FS_FEATURE_OUT_OF_LINE_HEADERS) == 0) {
+        return;
+    }
+    // write through, the cache must stay valid
+    SummaryEntry &entry = getSummaryEntry(slot);
+    entry.id = block.getId();
+    entry.writeTime = block.getLastWriteTime();
+    entry.sequence = nextSequence++;
+    if (cold) {
+        entry.sequence |= SDI4FS_SUMMARY_COLD_BIT;
+    }
+    // a new segment was read into the cache, which moved the stream
+    if (!continued || (slot - 1) % SDI4FS_SLOTS_PER_SEGMENT == 0) {
+        dev.seekp(summaryStart_bptr + (static_cast<uint64_t> (slot - 1) * SDI4FS_SUMMARY_ENTRY_SIZE));
+    }
+    writeN(dev, &entry, SDI4FS_SUMMARY_ENTRY_SIZE);
+}
+
+uint32_t FS::gc(uint32_t &head, uint32_t *reserved) {
+    // a reserved slot is always there, everybody else must leave the reserved and the in-flight slots alone
+    bool covered = reserved != NULL && *reserved != 0;
     // full?
-    if (usedBlocks == logSize) {
-        std::cout << "fs: warning - cannot alloc new block, fs full" << std::endl;
+    if (!covered && usedBlocks + pinnedBlocks + reservedSlots.size() + reservedBlocks >= logSize) {
+        if (pinnedBlocks != 0) {
+            std::cout << "fs: warning - cannot alloc new block, the remaining blocks are held by snapshots" << std::endl;
+        } else {
+            std::cout << "fs: warning - cannot alloc new block, fs full" << std::endl;
+        }
         return 0;
     }
     uint32_t result = 0;
     // search a reusable block (limit of for loop prevents endless loops in inconsistent fs)
     for (uint32_t i = 0; i < logSize; ++i) {
-        // read id of block at write_ptr
-        dev.seekg(logStart_bptr + ((write_ptr - 1) * SDI4FS_BLOCK_SIZE));
+        // reserved, but not yet written by another thread?
+        if (reservedSlots.find(head) != reservedSlots.end()) {
+            ++head;
+            if (head > logSize) {
+                head = 1;
+            }
+            continue;
+        }
+        // read id of block at head
         uint32_t id;
-        read32(dev, &id);
+        uint32_t writeTime;
+        readSlotHeader(head, &id, &writeTime);
         // sanity
         if (id > logSize) {
-            std::cout << "fs: fatal error - inconsistency, invalid id " << id << " at write_ptr " << write_ptr << std::endl; 
+            std::cout << "fs: fatal error - inconsistency, invalid id " << id << " at log pos " << head << std::endl; 
         }
         // free or reclaimable?
         if (id == 0) {
             // free
-            result = write_ptr;
+            result = head;
             break;
-        } else if (bmap[id - 1] != write_ptr) {
+        } else if (loadBMapEntry(&bmap[id - 1]) != head && !pinnedBySnapshot(id, head)) {
             // reclaimable
             // delete block (null id)
-            dev.seekp(logStart_bptr + ((write_ptr - 1) * SDI4FS_BLOCK_SIZE));
-            write32(dev, 0);
+            clearSlot(head);
         } else {
             // continue search at next block
-            ++write_ptr;
-            if (write_ptr > logSize) {
-                write_ptr = 1;
+            ++head;
+            if (head > logSize) {
+                head = 1;
             }
         }
     }
     // sanity check
+    if (result == 0 && !snapshots.empty()) {
+        // usedBlocks only counts live blocks
+        std::cout << "fs: warning - cannot alloc new block, the remaining blocks are held by snapshots" << std::endl;
+        return 0;
+    }
     if (result == 0) {
         // this should never happen, the full-check at the beginning should catch these cases
         std::cout << "fs: fatal error - inconsistency - unable to find a useable block in gc" << std::endl;
         return 0;
     }
+    if (covered) {
+        --*reserved;
+        --reservedBlocks;
+    }
     return result;
 }
 
+bool FS::isColdBlock(Block &block) {
+    // without sequence numbers, bmap recovery needs the log position to follow the write order, so there is only one head
+    if ((features & SDI4FS_FEATURE_OUT_OF_LINE_HEADERS) == 0) {
+        return false;
+    }
+    // a DataBlock that is rewritten is likely to be rewritten again
+    return dynamic_cast<DataBlock*> (&block) != NULL && loadBMapEntry(&bmap[block.getId() - 1]) == 0;
+}
+
+bool FS::hasFreeBlocks(uint32_t n) {
+    std::lock_guard<std::mutex> allocGuard(allocLock);
+    // slots kept for snapshots, reserved by open files or being written are not free either
+    return usedBlocks + pinnedBlocks + reservedSlots.size() + reservedBlocks + n <= logSize;
+}
+
+bool FS::reserveBlocks(uint32_t *reserved, uint32_t n) {
+    if (*reserved >= n) {
+        return true;
+    }
+    std::lock_guard<std::mutex> allocGuard(allocLock);
+    if (usedBlocks + pinnedBlocks + reservedSlots.size() + reservedBlocks + (n - *reserved) > logSize) {
+        return false;
+    }
+    reservedBlocks += n - *reserved;
+    *reserved = n;
+    return true;
+}
+
+void FS::releaseBlocks(uint32_t *reserved, uint32_t keep) {
+    if (*reserved <= keep) {
+        return;
+    }
+    std::lock_guard<std::mutex> allocGuard(allocLock);
+    reservedBlocks -= *reserved - keep;
+    *reserved = keep;
+}
+
 uint32_t FS::getNextBlockID() {
-    // full?
-    if (usedBlocks == logSize) {
+    std::lock_guard<std::mutex> allocGuard(allocLock);
+    // full? (slots kept for snapshots count as used)
+    if (usedBlocks + pinnedBlocks >= logSize) {
         std::cout << "fs: warning - cannot alloc id for new block, fs full" << std::endl;
         return 0;
     }
@@ -1085,7 +1700,7 @@ uint32_t FS::getNextBlockID() {
             bmapIndex -= logSize;
         }
         // is this id available?
-        if (bmap[bmapIndex - 1] == 0) {
+        if (loadBMapEntry(&bmap[bmapIndex - 1]) == 0) {
             // yes, return
             nextBlockID = bmapIndex + 1;
             if (nextBlockID > logSize) {
@@ -1100,27 +1715,141 @@ uint32_t FS::getNextBlockID() {
     return 0;
 }
 
-void FS::saveBlock(Block &block) {
+bool FS::saveBlock(Block &block, uint32_t *reserved) {
+    if (readOnly) {
+        // all modifying methods are rejected before they get here
+        std::cout << "fs: error - attempting to save block " << block.getId() << " on read-only fs" << std::endl;
+        return false;
+    }
     // get log address for this block
-    uint32_t log_ptr = gc();
+    bool cold;
+    uint32_t log_ptr = reserveLogSlot(block, &cold, reserved);
     if (log_ptr == 0) {
-        return; // gc() already prints a message
-    }
-    // jump to adr
-    dev.seekp(logStart_bptr + ((log_ptr - 1) * SDI4FS_BLOCK_SIZE));
-    // write bĺock
-    block.save(dev);
+        return false; // gc() already prints a message
+    }
+    // the allocator is free again while writing, other writers can reserve their slots meanwhile
+    {
+        std::lock_guard<std::mutex> devGuard(devLock);
+        // jump to adr
+        dev.seekp(logStart_bptr + (static_cast<uint64_t> (log_ptr - 1) * SDI4FS_BLOCK_SIZE));
+        // write bĺock
+        block.save(dev);
+        writeSummaryEntry(log_ptr, block, cold);
+    }
+    // publish the new location only after the block is written (readers do not lock)
+    std::lock_guard<std::mutex> allocGuard(allocLock);
     // new block (= never written before)
-    if (bmap[block.getId() - 1] == 0) {
+    if (loadBMapEntry(&bmap[block.getId() - 1]) == 0) {
         usedBlocks++;
     }
     // update bmap
-    bmap[block.getId() - 1] = log_ptr;
-    // advance write_ptr
-    ++write_ptr;
-    if (write_ptr > logSize) {
-        write_ptr = 1;
+    setBMapEntry(block.getId(), log_ptr);
+    reservedSlots.erase(log_ptr);
+    return true;
+}
+
+bool FS::saveBlocks(const std::vector<Block*> &blocks, uint32_t *reserved) {
+    if (blocks.empty()) {
+        return true;
+    }
+    if (readOnly) {
+        std::cout << "fs: error - attempting to save " << blocks.size() << " blocks on read-only fs" << std::endl;
+        return false;
+    }
+    // reserve all slots at once, usually they are consecutive
+    std::vector<uint32_t> slots;
+    std::vector<bool> coldSlots;
+    {
+        std::lock_guard<std::mutex> allocGuard(allocLock);
+        std::lock_guard<std::mutex> devGuard(devLock);
+        for (std::size_t i = 0; i < blocks.size(); ++i) {
+            bool cold = isColdBlock(*blocks[i]);
+            uint32_t &head = cold ? coldWritePtr : write_ptr;
+            uint32_t log_ptr = gc(head, reserved);
+            if (log_ptr == 0) {
+                break; // gc() already prints a message
+            }
+            reservedSlots.insert(log_ptr);
+            ++head;
+            if (head > logSize) {
+                head = 1;
+            }
+            slots.push_back(log_ptr);
+            coldSlots.push_back(cold);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> devGuard(devLock);
+        for (std::size_t i = 0; i < slots.size(); ++i) {
+            // consecutive slots continue the previous write
+            if (i == 0 || slots[i] != slots[i - 1] + 1) {
+                dev.seekp(logStart_bptr + (static_cast<uint64_t> (slots[i] - 1) * SDI4FS_BLOCK_SIZE));
+            }
+            blocks[i]->save(dev);
+        }
+        // out-of-line headers after all blocks, so the block writes stay sequential, consecutive slots have consecutive entries
+        for (std::size_t i = 0; i < slots.size(); ++i) {
+            writeSummaryEntry(slots[i], *blocks[i], coldSlots[i], i != 0 && slots[i] == slots[i - 1] + 1);
+        }
+    }
+    // publish the new locations
+    std::lock_guard<std::mutex> allocGuard(allocLock);
+    for (std::size_t i = 0; i < slots.size(); ++i) {
+        if (loadBMapEntry(&bmap[blocks[i]->getId() - 1]) == 0) {
+            usedBlocks++;
+        }
+        setBMapEntry(blocks[i]->getId(), slots[i]);
+        reservedSlots.erase(slots[i]);
+    }
+    return slots.size() == blocks.size();
+}
+
+bool FS::saveDataUnit(std::vector<std::unique_ptr<DataBlock>> &unit, uint32_t *reserved) {
+    std::vector<Block*> blocks;
+    for (auto &block : unit) {
+        blocks.push_back(block.get());
+    }
+    bool saved = saveBlocks(blocks, reserved);
+    if (!saved) {
+        std::cout << "fs: error - could only save part of a data unit of " << unit.size() << " DataBlocks" << std::endl;
+    }
+    unit.clear();
+    return saved;
+}
+
+bool FS::finishWrite(File &file, uint32_t size_b, std::vector<std::unique_ptr<DataBlock>> &unit, std::unordered_map<uint32_t, Block*> &changedMetaBlocks) {
+    uint32_t *reserved = file.getReservedBlocks();
+    // DataBlocks first, the meta blocks reference them
+    bool saved = saveDataUnit(unit, reserved);
+    if (saved) {
+        file.getPrimaryINode().setInternalSize_b(size_b);
+    } // else the lost DataBlocks must not become readable, keep the old size
+    std::vector<Block*> metaBlocks;
+    for (std::pair<const uint32_t, SDI4FS::Block*> &block : changedMetaBlocks) {
+        metaBlocks.push_back(block.second);
+    }
+    saved = saveBlocks(metaBlocks, reserved) && saved;
+    // the INode and a dirty cached DataBlock are saved later (flushFile), they keep their slots
+    releaseBlocks(reserved, file.cachedDataBlockIsDirty() ? 2 : 1);
+    return saved;
+}
+
+uint32_t FS::reserveLogSlot(Block &block, bool *cold, uint32_t *reserved) {
+    std::lock_guard<std::mutex> allocGuard(allocLock);
+    std::lock_guard<std::mutex> devGuard(devLock);
+    *cold = isColdBlock(block);
+    uint32_t &head = *cold ? coldWritePtr : write_ptr;
+    uint32_t log_ptr = gc(head, reserved);
+    if (log_ptr == 0) {
+        return 0;
+    }
+    reservedSlots.insert(log_ptr);
+    // advance head
+    ++head;
+    if (head > logSize) {
+        head = 1;
     }
+    return log_ptr;
 }
 
 void FS::freeBlock(uint32_t id) {
@@ -1134,30 +1863,188 @@ void FS::freeBlock(uint32_t id) {
         std::cout << "fs: cannot free block with id 1 (root node!)" << std::endl;
         return;
     }
+    std::lock_guard<std::mutex> allocGuard(allocLock);
+    std::lock_guard<std::mutex> devGuard(devLock);
     // remove registration in bmap
-    bmap[id - 1] = 0;
+    setBMapEntry(id, 0);
+    // the id may be reused for any kind of block
+    setINodeType(id, 0);
     --usedBlocks;
 }
 
-std::unique_ptr<Directory> FS::searchParent(std::string absolutePath) {
-    // standard sanity checks
-    if (absolutePath.find_first_of("/") != 0) {
-        // not an absolute path
-        std::cout << "fs: searchParent: cannot traverse path \"" << absolutePath << "\", path is not absolute" << std::endl;
-        return std::unique_ptr<Directory>(nullptr);
+void FS::releaseBlock(uint32_t id) {
+    if (unshareBlock(id)) {
+        // still referenced by another file
+        return;
+    }
+    freeBlock(id);
+}
+
+void FS::shareBlock(uint32_t id) {
+    std::lock_guard<std::mutex> allocGuard(allocLock);
+    ++sharedBlocks[id];
+}
+
+bool FS::unshareBlock(uint32_t id) {
+    std::lock_guard<std::mutex> allocGuard(allocLock);
+    auto iter = sharedBlocks.find(id);
+    if (iter == sharedBlocks.end()) {
+        return false;
+    }
+    if (--iter->second == 0) {
+        sharedBlocks.erase(iter);
+    }
+    return true;
+}
+
+void FS::loadSharedBlocks() {
+    dev.seekg(36);
+    read32(dev, &sharedBlocksTable);
+    if (sharedBlocksTable == 0) {
+        return;
+    }
+    std::unique_ptr<File> table = loadFile(sharedBlocksTable);
+    if (!table) {
+        std::cout << "fs: error - cannot load shared block table " << sharedBlocksTable << std::endl;
+        sharedBlocksTable = 0;
+        return;
+    }
+    // pairs of (blockID, additional references)
+    std::vector<uint32_t> entries(table->getPrimaryINode().getInternalSize_b() / sizeof (uint32_t));
+    if (entries.empty()) {
+        return;
+    }
+    IOVec iov = {&entries[0], entries.size() * sizeof (uint32_t)};
+    if (!readvImpl(*table.get(), &iov, 1, 0)) {
+        std::cout << "fs: error - cannot read shared block table " << sharedBlocksTable << std::endl;
+        return;
+    }
+    for (std::size_t i = 0; i + 1 < entries.size(); i += 2) {
+        sharedBlocks[entries[i]] = entries[i + 1];
+    }
+    std::cout << "fs: " << sharedBlocks.size() << " shared data blocks" << std::endl;
+}
+
+bool FS::saveSharedBlocks() {
+    // the previous table is outdated
+    if (sharedBlocksTable != 0) {
+        std::unique_ptr<File> table = loadFile(sharedBlocksTable);
+        if (table) {
+            std::list<uint32_t> blocks;
+            table->blocks(blocks);
+            for (uint32_t id : blocks) {
+                freeBlock(id);
+            }
+        }
+        sharedBlocksTable = 0;
+    }
+    if (sharedBlocks.empty()) {
+        return true;
+    }
+    std::vector<uint32_t> entries;
+    for (auto &entry : sharedBlocks) {
+        entries.push_back(entry.first);
+        entries.push_back(entry.second);
+    }
+    uint32_t tableID = getNextBlockID();
+    if (tableID == 0) {
+        return false;
+    }
+    std::unique_ptr<File> table(new File(dataBlockListCreator, std::unique_ptr<FileINode>(new FileINode(tableID))));
+    IOVec iov = {&entries[0], entries.size() * sizeof (uint32_t)};
+    if (!writevImpl(*table.get(), &iov, 1, 0)) {
+        return false;
+    }
+    flushFileImpl(*table.get());
+    sharedBlocksTable = tableID;
+    return true;
+}
+
+void FS::setBMapEntry(uint32_t id, uint32_t logPtr) {
+    for (auto &snapshot : snapshots) {
+        snapshot.second->preserve(id - 1);
     }
+    uint32_t oldPtr = loadBMapEntry(&bmap[id - 1]);
+    if (oldPtr != 0 && oldPtr != logPtr && pinnedBySnapshot(id, oldPtr)) {
+        // the old slot was live until now, so it is counted only once, no matter how many snapshots reference it
+        ++pinnedBlocks;
+    }
+    storeBMapEntry(&bmap[id - 1], logPtr);
+}
+
+bool FS::pinnedBySnapshot(uint32_t id, uint32_t logPtr) {
+    for (auto &snapshot : snapshots) {
+        if (snapshot.second->lookup(id - 1) == logPtr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t FS::createSnapshot() {
+    std::lock_guard<RWLock> fsGuard(fsLock);
+    // the snapshot should contain all completed writes, and views read the device through another stream
+    for (auto &file : openFiles) {
+        flushFileImpl(*file.second);
+    }
+    {
+        std::lock_guard<std::mutex> devGuard(devLock);
+        dev.flush();
+    }
+    std::lock_guard<std::mutex> allocGuard(allocLock);
+    if (++lastSnapshotID == 0) {
+        // wrap-around, zero is the error value
+        ++lastSnapshotID;
+    }
+    snapshots[lastSnapshotID].reset(new Snapshot(bmap, logSize, usedBlocks));
+    return lastSnapshotID;
+}
 
-    std::list<std::string> dirs;
-    split(dirs, absolutePath, '/');
+bool FS::releaseSnapshot(uint32_t snapshotID) {
+    std::lock_guard<std::mutex> allocGuard(allocLock);
+    if (snapshots.erase(snapshotID) == 0) {
+        return false;
+    }
+    countPinnedBlocks();
+    return true;
+}
 
-    // remove leading empty string and trailing filename for path traversal
-    dirs.pop_front();
-    dirs.pop_back();
+void FS::countPinnedBlocks() {
+    pinnedBlocks = 0;
+    if (snapshots.empty()) {
+        return;
+    }
+    // each slot holds one block, so a slot is pinned iff a snapshot has it as an old position of that block
+    std::vector<uint32_t> oldPtrs;
+    for (uint32_t i = 0; i < logSize; ++i) {
+        uint32_t livePtr = loadBMapEntry(&bmap[i]);
+        oldPtrs.clear();
+        for (auto &snapshot : snapshots) {
+            uint32_t snapshotPtr = snapshot.second->lookup(i);
+            if (snapshotPtr != 0 && snapshotPtr != livePtr && std::find(oldPtrs.begin(), oldPtrs.end(), snapshotPtr) == oldPtrs.end()) {
+                oldPtrs.push_back(snapshotPtr);
+            }
+        }
+        pinnedBlocks += oldPtrs.size();
+    }
+}
+
+bool FS::copySnapshotBMap(uint32_t snapshotID, uint32_t *target, uint32_t &snapshotUsedBlocks) {
+    std::lock_guard<std::mutex> allocGuard(allocLock);
+    auto iter = snapshots.find(snapshotID);
+    if (iter == snapshots.end()) {
+        return false;
+    }
+    iter->second->copyTo(target);
+    snapshotUsedBlocks = iter->second->getUsedBlocks();
+    return true;
+}
 
-    // start path traversal with root dir (id 1)
+std::unique_ptr<Directory> FS::searchParent(const ResolvedPath &path) {
+    // start path traversal with root dir (id 1), stop before the last name
     std::unique_ptr<Directory> currentDir = loadDirectory(1);
-    for (auto iter = dirs.begin(); iter != dirs.end(); ++iter) {
-        uint32_t nextDirID = currentDir->searchHardlink(*iter);
+    for (std::size_t i = 0; i + 1 < path.getDepth(); ++i) {
+        uint32_t nextDirID = currentDir->searchHardlink(path.component(i));
         if (nextDirID == 0) {
             // no such file or dir
             currentDir.reset(nullptr);
@@ -1165,7 +2052,7 @@ std::unique_ptr<Directory> FS::searchParent(std::string absolutePath) {
         }
         // make sure this is a directory
         if (peekINodeType(nextDirID) != SDI4FS_INODE_TYPE_DIR) {
-            std::cout << "fs: path traversal impossible, item " << *iter << " is not a directory" << std::endl;
+            std::cout << "fs: path traversal impossible, item " << path.component(i) << " is not a directory" << std::endl;
             currentDir.reset(nullptr);
             break;
         }
@@ -1192,72 +2079,182 @@ uint8_t FS::peekINodeType(uint32_t id) {
         std::cout << "fs: error - tried to peek at INode with id zero" << std::endl;
         return 0;
     }
+    std::lock_guard<std::mutex> devGuard(devLock);
     // get pos in log
     uint32_t logPtr = lookupBlockAddress(id);
     if (logPtr == 0 || logPtr > logSize) {
         std::cout << "fs: error - peeking INode type failed - not found: " << id << std::endl;
         return 0;
     }
+    // known?
+    uint32_t index = id - 1;
+    uint8_t cached = (inodeTypes[index / 4] >> ((index % 4) * 2)) & 0x3;
+    if (cached != 0) {
+        return cached;
+    }
     // seek to block start + offset of type field
-    dev.seekg(logStart_bptr + ((logPtr - 1) * SDI4FS_BLOCK_SIZE) + 16);
+    dev.seekg(logStart_bptr + (static_cast<uint64_t> (logPtr - 1) * SDI4FS_BLOCK_SIZE) + 16);
 
     // read type (4 bits) + inlined (1bit)
     uint8_t typeAndInline;
     read8(dev, &typeAndInline);
-    return (typeAndInline >> 4) & 0xF;
+    uint8_t type = (typeAndInline >> 4) & 0xF;
+    setINodeType(id, type);
+    return type;
+}
+
+void FS::setINodeType(uint32_t id, uint8_t type) {
+    // only these fit into 2 bits, everything else stays unknown
+    if (type != SDI4FS_INODE_TYPE_DIR && type != SDI4FS_INODE_TYPE_REGULARFILE) {
+        type = 0;
+    }
+    uint32_t index = id - 1;
+    uint8_t shift = (index % 4) * 2;
+    inodeTypes[index / 4] = (inodeTypes[index / 4] & ~(0x3 << shift)) | (type << shift);
 }
 
-uint32_t FS::fileSize(std::string absolutePath) {
-    absolutePath = normalizePath(absolutePath);
-    if (absolutePath.find_first_of("/") != 0) {
+bool FS::stat(PathView absolutePath, StatInfo &stat) {
+    SharedLockGuard fsGuard(fsLock);
+    return statImpl(absolutePath, stat);
+}
+
+bool FS::statImpl(PathView absolutePath, StatInfo &stat) {
+    ResolvedPath path;
+    if (!path.parse(absolutePath)) {
         // not an absolute path
-        std::cout << "fs: fileSize: cannot stat file with path \"" << absolutePath << "\", path is not absolute" << std::endl;
-        return 0;
+        std::cout << "fs: stat: cannot stat path \"" << absolutePath << "\", invalid path" << std::endl;
+        return false;
     }
-    // find parent node
-    std::unique_ptr<Directory> parent = searchParent(absolutePath);
-    // parent exists?
-    if (!parent) {
-        std::cout << "fs: fileSize: cannot stat file with path \"" << absolutePath << "\", parent does not exist" << std::endl;
-        return 0;
+    uint32_t id = 1; // default to root
+    // root dir is its own parent
+    if (!path.isRoot()) {
+        // find parent node
+        std::unique_ptr<Directory> parent = searchParent(path);
+        // parent exists?
+        if (!parent) {
+            std::cout << "fs: stat: cannot stat path \"" << absolutePath << "\", parent does not exist" << std::endl;
+            return false;
+        }
+        // file or dir exists?
+        id = parent->searchHardlink(path.lastName());
+        if (id == 0) {
+            std::cout << "fs: stat: cannot stat path \"" << absolutePath << "\", no such file or directory" << std::endl;
+            return false;
+        }
     }
-    // file exists?
-    uint32_t id = parent->searchHardlink(lastName(absolutePath));
-    if (id == 0) {
-        std::cout << "fs: fileSize: cannot stat file with path \"" << absolutePath << "\", file does not exist" << std::endl;
+    return statByIdImpl(id, stat);
+}
+
+bool FS::statById(uint32_t id, StatInfo &stat) {
+    SharedLockGuard fsGuard(fsLock);
+    return statByIdImpl(id, stat);
+}
+
+bool FS::statByIdImpl(uint32_t id, StatInfo &stat) {
+    std::lock_guard<std::mutex> devGuard(devLock);
+    // get pos in log
+    uint32_t logPtr = lookupBlockAddress(id);
+    if (logPtr == 0 || logPtr > logSize) {
+        std::cout << "fs: error - stat failed - inode not found: " << id << std::endl;
+        return false;
+    }
+    // seek to pos
+    dev.seekg(logStart_bptr + (static_cast<uint64_t> (logPtr - 1) * SDI4FS_BLOCK_SIZE));
+    // read the INode header only (same layout as Block + INode)
+    uint32_t blockID;
+    uint8_t typeAndInline;
+    read32(dev, &blockID);
+    read32(dev, &stat.lastWriteTime);
+    read32(dev, &stat.creationTime);
+    read32(dev, &stat.size_b);
+    read8(dev, &typeAndInline);
+    dev.seekg(1, dev.cur);
+    read16(dev, &stat.linkCounter);
+    // sanity check
+    if (blockID != id) {
+        std::cout << "fs: error - inconsistency, tried to stat inode " << id << ", but got " << blockID << std::endl;
+        return false;
+    }
+    stat.id = id;
+    stat.type = (typeAndInline >> 4) & 0xF;
+    setINodeType(id, stat.type);
+    if (stat.type != SDI4FS_INODE_TYPE_DIR && stat.type != SDI4FS_INODE_TYPE_REGULARFILE) {
+        std::cout << "fs: error - stat failed - block " << id << " has unknown INode type " << (int) stat.type << std::endl;
+        return false;
+    }
+    // disk size: all blocks of the INode, computed from the header (the DataBlock size depends on the fs format)
+    if ((typeAndInline & 0x08) != 0) {
+        // inlined
+        stat.diskSize_b = SDI4FS_BLOCK_SIZE;
+        return true;
+    }
+    switch (stat.type) {
+        case SDI4FS_INODE_TYPE_REGULARFILE:
+        {
+            // number of DataBlocks and DataBlockLists follows from the size (never less than 1 list, none if extent-mapped)
+            uint32_t numberOfDataBlocks = (stat.size_b + dataBlockSize_b - 1) / dataBlockSize_b;
+            uint32_t numberOfDataBlockLists = (numberOfDataBlocks + SDI4FS_MAX_DATABLOCKS_PER_DATABLOCKLIST - 1) / SDI4FS_MAX_DATABLOCKS_PER_DATABLOCKLIST;
+            if ((typeAndInline & 0x04) != 0) {
+                numberOfDataBlockLists = 0;
+            } else if (numberOfDataBlockLists == 0) {
+                numberOfDataBlockLists = 1;
+            }
+            // 1 FileINode + #DataBlockLists + #DataBlocks
+            stat.diskSize_b = (1 + numberOfDataBlockLists + numberOfDataBlocks) * SDI4FS_BLOCK_SIZE;
+            return true;
+        }
+        case SDI4FS_INODE_TYPE_DIR:
+        {
+            // count DirectoryEntryLists, the ids directly follow the header
+            uint32_t listIDs[SDI4FS_MAX_DIRENTRYLISTS_PER_DIR];
+            readN(dev, &listIDs[0], sizeof (listIDs));
+            uint32_t numberOfDirEntryLists = 0;
+            for (uint32_t i = 0; i < SDI4FS_MAX_DIRENTRYLISTS_PER_DIR; ++i) {
+                if (listIDs[i] != 0) {
+                    ++numberOfDirEntryLists;
+                }
+            }
+            // +1 is self
+            stat.diskSize_b = (numberOfDirEntryLists + 1) * SDI4FS_BLOCK_SIZE;
+            return true;
+        }
+    }
+    // unreachable, type checked above
+    return false;
+}
+
+uint32_t FS::fileSize(PathView absolutePath) {
+    SharedLockGuard fsGuard(fsLock);
+    StatInfo info;
+    if (!statImpl(absolutePath, info)) {
+        std::cout << "fs: fileSize: cannot stat file with path \"" << absolutePath << "\"" << std::endl;
         return 0;
     }
     // is this even a file?
-    if (peekINodeType(id) != SDI4FS_INODE_TYPE_REGULARFILE) {
+    if (info.type != SDI4FS_INODE_TYPE_REGULARFILE) {
         std::cout << "fs: fileSize: cannot stat \"" << absolutePath << "\", not a file" << std::endl;
         return 0;
     }
-    // load file
-    std::unique_ptr<File> file = loadFile(id);
-    if (!file) {
-        // should never happen
-        std::cout << "fs: fatal error - inconsistency - unable to load file with primary inode id " << id << std::endl;
-        return 0;
-    }
-    return file->getPrimaryINode().getInternalSize_b();
+    return info.size_b;
 }
 
-uint32_t FS::openFile(std::string absolutePath) {
-    absolutePath = normalizePath(absolutePath);
-    if (absolutePath.find_first_of("/") != 0) {
-        // not an absolute path
-        std::cout << "fs: openFile: cannot open file with path \"" << absolutePath << "\", path is not absolute" << std::endl;
+uint32_t FS::openFile(PathView absolutePath) {
+    std::lock_guard<RWLock> fsGuard(fsLock);
+    ResolvedPath path;
+    if (!path.parse(absolutePath) || path.isRoot()) {
+        // not an absolute path, or no name given
+        std::cout << "fs: openFile: cannot open file with path \"" << absolutePath << "\", invalid path" << std::endl;
         return 0;
     }
     // find parent node
-    std::unique_ptr<Directory> parent = searchParent(absolutePath);
+    std::unique_ptr<Directory> parent = searchParent(path);
     // parent exists?
     if (!parent) {
         std::cout << "fs: openFile: cannot open file with path \"" << absolutePath << "\", parent does not exist" << std::endl;
         return 0;
     }
     // file exists?
-    uint32_t id = parent->searchHardlink(lastName(absolutePath));
+    uint32_t id = parent->searchHardlink(path.lastName());
     if (id == 0) {
         std::cout << "fs: openFile: cannot open file with path \"" << absolutePath << "\", file does not exist" << std::endl;
         return 0;
@@ -1284,88 +2281,180 @@ uint32_t FS::openFile(std::string absolutePath) {
 }
 
 void FS::closeFile(uint32_t handle) {
-    flushFile(handle);
-    openFiles.erase(handle);
+    std::lock_guard<RWLock> fsGuard(fsLock);
+    auto iter = openFiles.find(handle);
+    if (iter != openFiles.end()) {
+        if (!flushFileImpl(*iter->second)) {
+            std::cout << "fs: error - cannot save file " << iter->second->getPrimaryINode().getId() << " on close" << std::endl;
+        }
+        releaseBlocks(iter->second->getReservedBlocks(), 0);
+        openFiles.erase(iter);
+    }
 }
 
-void FS::flushFile(uint32_t handle) {
-    if (openFiles.find(handle) != openFiles.end()) {
-        // save metadata (INode)
-        saveBlock(openFiles[handle]->getPrimaryINode());
-        if (openFiles[handle]->cachedDataBlockIsDirty()) {
-            saveBlock(*(openFiles[handle]->releaseCachedDataBlock().get()));
-        }
-        // force flush in caching layer/block device server
-        dev.flush();
+bool FS::flushFile(uint32_t handle) {
+    SharedLockGuard fsGuard(fsLock);
+    auto iter = openFiles.find(handle);
+    if (iter == openFiles.end()) {
+        return false;
     }
+    std::lock_guard<std::mutex> fileGuard(iter->second->getLock());
+    return flushFileImpl(*iter->second);
+}
+
+bool FS::flushFileImpl(File &file) {
+    if (readOnly) {
+        // reads never dirty anything
+        return true;
+    }
+    // save metadata (INode), the slots were reserved by the writes
+    bool saved = saveBlock(file.getPrimaryINode(), file.getReservedBlocks());
+    if (file.cachedDataBlockIsDirty()) {
+        saved = saveBlock(*(file.releaseCachedDataBlock().get()), file.getReservedBlocks()) && saved;
+    }
+    // the INode is saved again on close
+    releaseBlocks(file.getReservedBlocks(), 1);
+    // force flush in caching layer/block device server
+    std::lock_guard<std::mutex> devGuard(devLock);
+    dev.flush();
+    return saved;
 }
 
 bool FS::read(uint32_t fileHandle, char* target, uint32_t pos, std::size_t n) {
+    IOVec iov = {target, n};
+    return readv(fileHandle, &iov, 1, pos);
+}
+
+bool FS::readv(uint32_t fileHandle, const IOVec *iov, std::size_t iovcnt, uint32_t pos) {
+    SharedLockGuard fsGuard(fsLock);
+    uint64_t n = totalLength(iov, iovcnt);
     // sanity checks
     if (n < 1) {
         std::cout << "fs: read failed, must read at least 1 byte" << std::endl;
         return false;
     }
-    if (openFiles.find(fileHandle) == openFiles.end()) {
+    // find() only, operator[] would insert
+    auto iter = openFiles.find(fileHandle);
+    if (iter == openFiles.end()) {
         std::cout << "fs: read failed, unknown handle " << fileHandle << std::endl;
         return false;
     }
-    File *file = openFiles[fileHandle].get();
-    uint32_t fileSize = file->getPrimaryINode().getInternalSize_b();
+    // reading moves the cached DataBlock
+    std::lock_guard<std::mutex> fileGuard(iter->second->getLock());
+    return readvImpl(*iter->second, iov, iovcnt, pos);
+}
+
+bool FS::readvImpl(File &file, const IOVec *iov, std::size_t iovcnt, uint32_t pos) {
+    uint64_t n = totalLength(iov, iovcnt);
+    uint32_t fileSize = file.getPrimaryINode().getInternalSize_b();
     if (pos >= fileSize || (pos + n > fileSize)) {
         std::cout << "fs: read failed, invalid byte range specified (from " << pos << ", n " << n << ", fileSize " << fileSize << ")" << std::endl;
         return false;
     }
     // special case: inline file
-    if (file->getPrimaryINode().isInlined()) {
-        return file->getPrimaryINode().readInline(target, pos, n);
+    if (file.getPrimaryINode().isInlined()) {
+        uint32_t inlinePos = pos;
+        for (std::size_t i = 0; i < iovcnt; ++i) {
+            if (iov[i].len != 0 && !file.getPrimaryINode().readInline(static_cast<char*> (iov[i].base), inlinePos, iov[i].len)) {
+                return false;
+            }
+            inlinePos += iov[i].len;
+        }
+        return true;
     }
 
     const uint32_t endPos = pos + n;
     uint32_t currentPos_b = pos;
-    uint32_t bytesCopied = 0;
+    // current fragment and position within it
+    std::size_t vecIndex = 0;
+    std::size_t vecOffset = 0;
+    // DataBlocks loaded ahead, unit[i] is the DataBlock unitStart + i
+    std::vector<std::unique_ptr<DataBlock>> unit;
+    uint32_t unitStart = 0;
     while (currentPos_b < endPos) {
         uint32_t bytesLeft = endPos - currentPos_b; // absolute
         // find block, then copy
-        uint32_t dataBlockNo = currentPos_b / SDI4FS_MAX_BYTES_PER_DATABLOCK;
-        uint32_t dataBlockId = file->getDataBlockID(dataBlockNo);
+        uint32_t dataBlockNo = currentPos_b / dataBlockSize_b;
+        uint32_t dataBlockId = file.getDataBlockID(dataBlockNo);
         // calc copy pos in this block
-        uint32_t blockStart = currentPos_b - (dataBlockNo * SDI4FS_MAX_BYTES_PER_DATABLOCK);
-        uint32_t blockBytes = SDI4FS_MAX_BYTES_PER_DATABLOCK - blockStart;
+        uint32_t blockStart = currentPos_b - (dataBlockNo * dataBlockSize_b);
+        uint32_t blockBytes = dataBlockSize_b - blockStart;
         if (blockBytes > bytesLeft) {
             blockBytes = bytesLeft;
         }
-        if (file->getCachedDataBlockID() != dataBlockId) {
+        if (file.getCachedDataBlockID() != dataBlockId) {
             // datablock must be loaded from disk
             // before, save changes to current block, if any
-            if (file->cachedDataBlockIsDirty()) {
-                std::unique_ptr<DataBlock> dataBlock = file->releaseCachedDataBlock();
-                saveBlock(*dataBlock.get());
+            if (file.cachedDataBlockIsDirty()) {
+                std::unique_ptr<DataBlock> dataBlock = file.releaseCachedDataBlock();
+                if (!saveBlock(*dataBlock.get(), file.getReservedBlocks())) {
+                    std::cout << "fs: read error, cannot save modified DataBlock " << dataBlock->getId() << " of file " << file.getPrimaryINode().getId() << std::endl;
+                    return false;
+                }
+            }
+            if (dataBlockNo < unitStart || dataBlockNo >= unitStart + unit.size()) {
+                // load the rest of the data unit at once, but not beyond the requested range
+                unitStart = dataBlockNo;
+                uint32_t unitEnd = std::min<uint32_t>((dataBlockNo / SDI4FS_DATA_UNIT_BLOCKS + 1) * SDI4FS_DATA_UNIT_BLOCKS, (endPos - 1) / dataBlockSize_b + 1);
+                unit.clear();
+                unit.resize(unitEnd - unitStart);
+                if (!loadDataBlocks(file, unitStart, unit)) {
+                    std::cout << "fs: read error, cannot load DataBlocks of file " << file.getPrimaryINode().getId() << std::endl;
+                    return false;
+                }
             }
-            file->setCachedDataBlock(loadDataBlock(dataBlockId));
+            file.setCachedDataBlock(std::move(unit[dataBlockNo - unitStart]));
+        }
+        // scatter over the fragments
+        while (blockBytes > 0) {
+            while (vecOffset == iov[vecIndex].len) {
+                ++vecIndex;
+                vecOffset = 0;
+            }
+            uint32_t chunk = std::min<std::size_t>(blockBytes, iov[vecIndex].len - vecOffset);
+            if (!file.readFromCachedDataBlock(static_cast<char*> (iov[vecIndex].base) + vecOffset, blockStart, chunk)) {
+                std::cout << "fs: read error in block " << dataBlockId << " file " << file.getPrimaryINode().getId() << std::endl;
+                return false;
+            } // else continue while loop
+            blockStart += chunk;
+            blockBytes -= chunk;
+            vecOffset += chunk;
+            currentPos_b += chunk;
         }
-        if (!file->readFromCachedDataBlock(&target[bytesCopied], blockStart, blockBytes)) {
-            std::cout << "fs: read error in block " << dataBlockId << " file " << file->getPrimaryINode().getId() << std::endl;
-            return false;
-        } // else continue while loop
-        currentPos_b += blockBytes;
-        bytesCopied += blockBytes;
     }
     return true;
 }
 
 bool FS::write(uint32_t fileHandle, const char* source, uint32_t pos, std::size_t n) {
+    // writev does not modify the fragments
+    IOVec iov = {const_cast<char*> (source), n};
+    return writev(fileHandle, &iov, 1, pos);
+}
+
+bool FS::writev(uint32_t fileHandle, const IOVec *iov, std::size_t iovcnt, uint32_t pos) {
+    if (rejectReadOnly("write")) {
+        return false;
+    }
+    // writes to different files run in parallel, only allocation and device access are serialized
+    SharedLockGuard fsGuard(fsLock);
+    uint64_t n = totalLength(iov, iovcnt);
     // sanity
     if (n < 1) {
         std::cout << "fs: write failed, must write at least 1 byte" << std::endl;
         return false;
     }
-    if (openFiles.find(fileHandle) == openFiles.end()) {
+    auto iter = openFiles.find(fileHandle);
+    if (iter == openFiles.end()) {
         std::cout << "fs: write failed, unknown handle " << fileHandle << std::endl;
         return false;
     }
-    File *file = openFiles[fileHandle].get();
-    FileINode &primaryINode = file->getPrimaryINode();
+    std::lock_guard<std::mutex> fileGuard(iter->second->getLock());
+    return writevImpl(*iter->second, iov, iovcnt, pos);
+}
+
+bool FS::writevImpl(File &file, const IOVec *iov, std::size_t iovcnt, uint32_t pos) {
+    uint64_t n = totalLength(iov, iovcnt);
+    FileINode &primaryINode = file.getPrimaryINode();
     uint32_t fSize = primaryINode.getInternalSize_b();
     if (pos > fSize) {
         std::cout << "fs: write failed, write start position must be smaller than or equal to the file size" << std::endl;
@@ -1377,109 +2466,429 @@ bool FS::write(uint32_t fileHandle, const char* source, uint32_t pos, std::size_
     }
     // check if this is doable inline-only
     if (primaryINode.isInlined() && (pos + n) <= SDI4FS_MAX_BYTES_PER_INODE) {
-        if (primaryINode.writeInline(source, pos, n)) {
-            primaryINode.setInternalSize_b(pos + n);
-            return true;
-        } else {
+        // the INode is saved by flushFile
+        if (!reserveBlocks(file.getReservedBlocks(), 1)) {
+            std::cout << "fs: write: cannot write, fs is too full to save the INode of file " << primaryINode.getId() << std::endl;
             return false;
         }
+        uint32_t inlinePos = pos;
+        for (std::size_t i = 0; i < iovcnt; ++i) {
+            if (iov[i].len != 0 && !primaryINode.writeInline(static_cast<const char*> (iov[i].base), inlinePos, iov[i].len)) {
+                return false;
+            }
+            inlinePos += iov[i].len;
+        }
+        primaryINode.setInternalSize_b(pos + n);
+        return true;
     }
     // from here on everything is done with non-inlined INodes, check if the INode is in that state yet and convert if required
     if (primaryINode.isInlined()) {
-        switchNonInline(file);
+        switchNonInline(&file);
+        if (primaryINode.isInlined()) {
+            return false; // switchNonInline already prints a message
+        }
     }
     // copy blockwise, add blocks as required
     const uint32_t endPos = pos + n;
     uint32_t currentPos_b = pos;
-    uint32_t bytesCopied = 0;
+    // current fragment and position within it
+    std::size_t vecIndex = 0;
+    std::size_t vecOffset = 0;
     std::unordered_map<uint32_t, Block*> changedMetaBlocks;
+    // completely written DataBlocks, saved together once a data unit is complete
+    std::vector<std::unique_ptr<DataBlock>> unit;
     while (currentPos_b < endPos) {
         uint32_t bytesLeft = endPos - currentPos_b; // absolute
-        uint32_t dataBlockNo = currentPos_b / SDI4FS_MAX_BYTES_PER_DATABLOCK;
-        // make sure the correct DataBlock is cached
-        if (file->getNumberOfDataBlocks() == dataBlockNo) {
-            // new block, this method creats one, saves the old (if required) and sets the new one as cached
-            addDataBlock(file, changedMetaBlocks);
+        uint32_t dataBlockNo = currentPos_b / dataBlockSize_b;
+        // make sure the correct DataBlock is cached, the old one joins the unit
+        if (file.getCachedDataBlockID() != file.getDataBlockID(dataBlockNo) && file.cachedDataBlockIsDirty()) {
+            unit.push_back(file.releaseCachedDataBlock());
+            if (unit.size() == SDI4FS_DATA_UNIT_BLOCKS && !saveDataUnit(unit, file.getReservedBlocks())) {
+                // the lost DataBlocks must not become readable, keep the old size
+                finishWrite(file, fSize, unit, changedMetaBlocks);
+                return false;
+            }
+        }
+        // staged DataBlocks, changed meta blocks, this DataBlock (or its copy), a new DataBlockList and the INode
+        if (!reserveBlocks(file.getReservedBlocks(), unit.size() + changedMetaBlocks.size() + 3 + file.getListConversionBlocks())) {
+            std::cout << "fs: write: cannot write, fs is too full, file " << primaryINode.getId() << std::endl;
+            finishWrite(file, std::max(fSize, currentPos_b), unit, changedMetaBlocks);
+            return false;
+        }
+        if (file.getNumberOfDataBlocks() == dataBlockNo) {
+            // new block, this method creats one and sets it as cached
+            if (!addDataBlock(&file, changedMetaBlocks)) {
+                // keep what was written so far
+                finishWrite(file, std::max(fSize, currentPos_b), unit, changedMetaBlocks);
+                return false;
+            }
         } else {
             // block was allocated previously, loading required?
-            if (file->getDataBlockID(dataBlockNo) != file->getCachedDataBlockID()) {
-                // save old cached block, if any
-                if (file->cachedDataBlockIsDirty()) {
-                    saveBlock(*(file->releaseCachedDataBlock().get()));
+            if (file.getDataBlockID(dataBlockNo) != file.getCachedDataBlockID()) {
+                // a block cached by an earlier call may be staged but not saved yet, take it back
+                auto staged = unit.begin();
+                while (staged != unit.end() && (*staged)->getId() != file.getDataBlockID(dataBlockNo)) {
+                    ++staged;
+                }
+                if (staged != unit.end()) {
+                    file.setCachedDataBlock(std::move(*staged));
+                    unit.erase(staged);
+                } else {
+                    file.setCachedDataBlock(loadDataBlock(file.getDataBlockID(dataBlockNo)));
+                }
+            }
+            // other files still reference this DataBlock? then write to a private copy
+            uint32_t sharedID = file.getCachedDataBlockID();
+            if (unshareBlock(sharedID)) {
+                // its slot is reserved above, only a new id is required
+                uint32_t copyID = getNextBlockID();
+                if (copyID == 0) {
+                    shareBlock(sharedID);
+                    std::cout << "fs: write: cannot write, fs is too full to copy shared data block " << sharedID << " of file " << primaryINode.getId() << std::endl;
+                    finishWrite(file, std::max(fSize, currentPos_b), unit, changedMetaBlocks);
+                    return false;
+                }
+                for (Block *block : file.copyCachedDataBlock(dataBlockNo, copyID)) {
+                    changedMetaBlocks[block->getId()] = block;
                 }
-                file->setCachedDataBlock(loadDataBlock(file->getDataBlockID(dataBlockNo)));
             }
         }
         // calc copy pos in this block
-        uint32_t blockStart = currentPos_b - (dataBlockNo * SDI4FS_MAX_BYTES_PER_DATABLOCK);
-        uint32_t blockBytes = SDI4FS_MAX_BYTES_PER_DATABLOCK - blockStart;
+        uint32_t blockStart = currentPos_b - (dataBlockNo * dataBlockSize_b);
+        uint32_t blockBytes = dataBlockSize_b - blockStart;
         if (blockBytes > bytesLeft) {
             blockBytes = bytesLeft;
         }
-        if (!file->writeToCachedDataBlock(&source[bytesCopied], blockStart, blockBytes)) {
-            std::cout << "fs: write error in block " << file->getCachedDataBlockID() << " file " << primaryINode.getId() << std::endl;
-            return false;
+        // gather from the fragments
+        while (blockBytes > 0) {
+            while (vecOffset == iov[vecIndex].len) {
+                ++vecIndex;
+                vecOffset = 0;
+            }
+            uint32_t chunk = std::min<std::size_t>(blockBytes, iov[vecIndex].len - vecOffset);
+            if (!file.writeToCachedDataBlock(static_cast<const char*> (iov[vecIndex].base) + vecOffset, blockStart, chunk)) {
+                std::cout << "fs: write error in block " << file.getCachedDataBlockID() << " file " << primaryINode.getId() << std::endl;
+                finishWrite(file, std::max(fSize, currentPos_b), unit, changedMetaBlocks);
+                return false;
+            }
+            blockStart += chunk;
+            blockBytes -= chunk;
+            vecOffset += chunk;
+            currentPos_b += chunk;
         }
-        currentPos_b += blockBytes;
-        bytesCopied += blockBytes;
     }
 
-    primaryINode.setInternalSize_b(pos + n);
-
-    for (std::pair<const uint32_t, SDI4FS::Block*> &block: changedMetaBlocks) {
-        saveBlock(*(block.second));
-    }
-    return true;
+    // the last block stays cached
+    return finishWrite(file, pos + n, unit, changedMetaBlocks);
 }
 
 bool FS::truncate(uint32_t fileHandle, uint32_t size) {
+    if (rejectReadOnly("truncate")) {
+        return false;
+    }
+    SharedLockGuard fsGuard(fsLock);
     // sanity
-    if (openFiles.find(fileHandle) == openFiles.end()) {
+    auto iter = openFiles.find(fileHandle);
+    if (iter == openFiles.end()) {
         std::cout << "fs: truncate failed, unknown handle " << fileHandle << std::endl;
         return false;
     }
-    File *file = openFiles[fileHandle].get();
+    File *file = iter->second.get();
+    std::lock_guard<std::mutex> fileGuard(file->getLock());
     uint32_t fSize = file->getPrimaryINode().getInternalSize_b();
     if (size >= fSize) {
         std::cout << "fs: truncate failed, new size (" << size << ") must be smaller than old size (" << fSize << ")" << std::endl;
         return false;
     }
-    uint32_t newNumberOfBlocks = (size / SDI4FS_MAX_BYTES_PER_DATABLOCK) + 1;
-    if (size % SDI4FS_MAX_BYTES_PER_DATABLOCK == 0) {
+    uint32_t newNumberOfBlocks = (size / dataBlockSize_b) + 1;
+    if (size % dataBlockSize_b == 0) {
         --newNumberOfBlocks;
     }
-    uint32_t oldNumberOfBlocks = (fSize / SDI4FS_MAX_BYTES_PER_DATABLOCK) + 1;
-    if (fSize % SDI4FS_MAX_BYTES_PER_DATABLOCK == 0) {
+    uint32_t oldNumberOfBlocks = (fSize / dataBlockSize_b) + 1;
+    if (fSize % dataBlockSize_b == 0) {
         --oldNumberOfBlocks;
     }
+    // dirty cached DataBlock plus 1 block as buffer, all other saves (DataBlockLists, INode)
+    // rewrite existing blocks and give back their old slot, just like the removed DataBlocks
+    uint32_t *reserved = file->getReservedBlocks();
+    if (!reserveBlocks(reserved, (file->cachedDataBlockIsDirty() ? 1 : 0) + 1)) {
+        std::cout << "fs: truncate failed, fs is too full, file " << file->getPrimaryINode().getId() << std::endl;
+        return false;
+    }
     // clear file cache before truncate
+    bool saved = true;
     if (file->cachedDataBlockIsDirty()) {
-        saveBlock(*(file->releaseCachedDataBlock().get()));
+        saved = saveBlock(*(file->releaseCachedDataBlock().get()), reserved);
+    }
+    // the cached DataBlock may be among the removed ones
+    file->releaseCachedDataBlock();
+    if (saved) {
+        saved = removeDataBlocks(file, oldNumberOfBlocks - newNumberOfBlocks);
+    }
+    if (saved) {
+        file->getPrimaryINode().setInternalSize_b(size);
+        saved = saveBlock(file->getPrimaryINode(), reserved);
+    }
+    releaseBlocks(reserved, 1);
+    return saved;
+}
+
+bool FS::copyRange(uint32_t srcHandle, uint32_t srcPos, uint32_t dstHandle, uint32_t dstPos, uint32_t n) {
+    if (rejectReadOnly("copyRange")) {
+        return false;
+    }
+    SharedLockGuard fsGuard(fsLock);
+    // sanity
+    if (n < 1) {
+        std::cout << "fs: copyRange failed, must copy at least 1 byte" << std::endl;
+        return false;
+    }
+    auto srcIter = openFiles.find(srcHandle);
+    auto dstIter = openFiles.find(dstHandle);
+    if (srcIter == openFiles.end() || dstIter == openFiles.end()) {
+        std::cout << "fs: copyRange failed, unknown handle " << (srcIter == openFiles.end() ? srcHandle : dstHandle) << std::endl;
+        return false;
+    }
+    File &src = *srcIter->second;
+    File &dst = *dstIter->second;
+    // std::lock prevents deadlocks between copies in opposite directions
+    std::unique_lock<std::mutex> srcGuard(src.getLock(), std::defer_lock);
+    std::unique_lock<std::mutex> dstGuard(dst.getLock(), std::defer_lock);
+    if (&src == &dst) {
+        srcGuard.lock();
+    } else {
+        std::lock(srcGuard, dstGuard);
+    }
+    uint32_t srcSize = src.getPrimaryINode().getInternalSize_b();
+    if (srcPos >= srcSize || n > srcSize - srcPos) {
+        std::cout << "fs: copyRange failed, invalid source range (from " << srcPos << ", n " << n << ", fileSize " << srcSize << ")" << std::endl;
+        return false;
+    }
+    if (&src == &dst && srcPos < dstPos + n && dstPos < srcPos + n) {
+        std::cout << "fs: copyRange failed, source and destination range overlap" << std::endl;
+        return false;
+    }
+    FileINode &dstINode = dst.getPrimaryINode();
+    if (dstPos > dstINode.getInternalSize_b()) {
+        std::cout << "fs: copyRange failed, destination position must be smaller than or equal to the file size" << std::endl;
+        return false;
+    }
+    if (static_cast<uint64_t> (dstPos) + n >= SDI4FS_MAX_FILE_SIZE) {
+        std::cout << "fs: copyRange failed, max file size (" << SDI4FS_MAX_FILE_SIZE << ") exceeded, file " << dstINode.getId() << std::endl;
+        return false;
+    }
+    // inlined content is at most one INode, nothing to stream
+    if (src.getPrimaryINode().isInlined() || (dstINode.isInlined() && dstPos + n <= SDI4FS_MAX_BYTES_PER_INODE)) {
+        char buffer[SDI4FS_MAX_BYTES_PER_INODE];
+        IOVec iov = {buffer, n};
+        return readvImpl(src, &iov, 1, srcPos) && writevImpl(dst, &iov, 1, dstPos);
+    }
+    if (dstINode.isInlined()) {
+        switchNonInline(&dst);
+        if (dstINode.isInlined()) {
+            return false; // switchNonInline already prints a message
+        }
+    }
+    // blocks are copied on the log, the cached DataBlocks must be saved and would go stale
+    for (File *file : {&src, &dst}) {
+        if (file->cachedDataBlockIsDirty() && !saveBlock(*(file->releaseCachedDataBlock().get()), file->getReservedBlocks())) {
+            std::cout << "fs: copyRange failed, cannot save modified DataBlock of file " << file->getPrimaryINode().getId() << std::endl;
+            return false;
+        }
+        file->releaseCachedDataBlock();
+    }
+    uint32_t *reserved = dst.getReservedBlocks();
+    uint32_t dstSize = dstINode.getInternalSize_b();
+
+    // fast path: every destination block is a copy of exactly one source block
+    const bool aligned = srcPos % dataBlockSize_b == 0 && dstPos % dataBlockSize_b == 0;
+    std::unordered_map<uint32_t, Block*> changedMetaBlocks;
+    // finished destination blocks of the current batch, saved together
+    std::vector<std::unique_ptr<DataBlock>> dstBlocks;
+    uint32_t done = 0;
+    while (done < n) {
+        // byte range of this batch
+        uint32_t firstDstBlock = (dstPos + done) / dataBlockSize_b;
+        uint32_t batchEnd = std::min<uint64_t>(n, static_cast<uint64_t> (firstDstBlock + SDI4FS_COPY_BATCH_BLOCKS) * dataBlockSize_b - dstPos);
+        // reserve for the worst case: every block is new (or a copy of a shared block),
+        // plus new DataBlockLists, the INode and the meta blocks changed by earlier batches
+        uint32_t batchBlocks = (dstPos + batchEnd - 1) / dataBlockSize_b - firstDstBlock + 1;
+        if (!reserveBlocks(reserved, batchBlocks + batchBlocks / SDI4FS_MAX_DATABLOCKS_PER_DATABLOCKLIST + 3 + dst.getListConversionBlocks()
+                + changedMetaBlocks.size())) {
+            std::cout << "fs: copyRange: cannot copy, fs is too full, file " << dstINode.getId() << std::endl;
+            // keep what was copied so far
+            finishWrite(dst, std::max(dstSize, dstPos + done), dstBlocks, changedMetaBlocks);
+            return false;
+        }
+        // load all source blocks of this batch
+        uint32_t firstSrcBlock = (srcPos + done) / dataBlockSize_b;
+        uint32_t lastSrcBlock = (srcPos + batchEnd - 1) / dataBlockSize_b;
+        std::vector<std::unique_ptr<DataBlock>> srcBlocks(lastSrcBlock - firstSrcBlock + 1);
+        if (!loadDataBlocks(src, firstSrcBlock, srcBlocks)) {
+            std::cout << "fs: copyRange failed, cannot load DataBlocks of file " << src.getPrimaryINode().getId() << std::endl;
+            finishWrite(dst, std::max(dstSize, dstPos + done), dstBlocks, changedMetaBlocks);
+            return false;
+        }
+        // fill destination blocks
+        while (done < batchEnd) {
+            uint32_t dataBlockNo = (dstPos + done) / dataBlockSize_b;
+            uint32_t blockStart = (dstPos + done) % dataBlockSize_b;
+            uint32_t blockBytes = std::min<uint32_t>(dataBlockSize_b - blockStart, batchEnd - done);
+            // previous content of the block is irrelevant if it is overwritten up to its end or the new end of the file
+            bool overwrite = blockStart == 0 && (blockBytes == dataBlockSize_b || done + blockBytes == n);
+            std::unique_ptr<DataBlock> target;
+            if (dataBlockNo == dst.getNumberOfDataBlocks()) {
+                // new block, addDataBlock sets it as cached
+                if (!addDataBlock(&dst, changedMetaBlocks)) {
+                    finishWrite(dst, std::max(dstSize, dstPos + done), dstBlocks, changedMetaBlocks);
+                    return false;
+                }
+                target = dst.releaseCachedDataBlock();
+            } else {
+                uint32_t id = dst.getDataBlockID(dataBlockNo);
+                if (unshareBlock(id)) {
+                    // other files still reference this DataBlock, write to a private copy
+                    // load the shared content first, the DataBlockList must not reference a copy that is never saved
+                    std::unique_ptr<DataBlock> shared;
+                    if (!overwrite) {
+                        shared = loadDataBlock(id);
+                        if (!shared) {
+                            shareBlock(id);
+                            std::cout << "fs: copyRange failed, cannot load shared data block " << id << " of file " << dstINode.getId() << std::endl;
+                            finishWrite(dst, std::max(dstSize, dstPos + done), dstBlocks, changedMetaBlocks);
+                            return false;
+                        }
+                    }
+                    uint32_t copyID = getNextBlockID();
+                    if (copyID == 0) {
+                        shareBlock(id);
+                        std::cout << "fs: copyRange: cannot copy, fs is too full to copy shared data block " << id << " of file " << dstINode.getId() << std::endl;
+                        finishWrite(dst, std::max(dstSize, dstPos + done), dstBlocks, changedMetaBlocks);
+                        return false;
+                    }
+                    for (Block *block : dst.setDataBlockID(dataBlockNo, copyID)) {
+                        changedMetaBlocks[block->getId()] = block;
+                    }
+                    if (overwrite) {
+                        target.reset(new DataBlock(copyID, dataBlockSize_b));
+                    } else {
+                        target.reset(new DataBlock(copyID, *shared.get()));
+                    }
+                } else if (overwrite) {
+                    target.reset(new DataBlock(id, dataBlockSize_b));
+                } else {
+                    target = loadDataBlock(id);
+                }
+            }
+            if (!target) {
+                std::cout << "fs: copyRange failed, cannot load DataBlock " << dataBlockNo << " of file " << dstINode.getId() << std::endl;
+                finishWrite(dst, std::max(dstSize, dstPos + done), dstBlocks, changedMetaBlocks);
+                return false;
+            }
+            if (aligned && overwrite) {
+                // whole block at once
+                DataBlock &source = *srcBlocks[(srcPos + done) / dataBlockSize_b - firstSrcBlock];
+                target.reset(new DataBlock(target->getId(), source));
+            } else {
+                // up to two source blocks per destination block
+                uint32_t copied = 0;
+                while (copied < blockBytes) {
+                    uint32_t srcBytePos = srcPos + done + copied;
+                    DataBlock &source = *srcBlocks[srcBytePos / dataBlockSize_b - firstSrcBlock];
+                    uint32_t srcStart = srcBytePos % dataBlockSize_b;
+                    uint32_t chunk = std::min<uint32_t>(blockBytes - copied, dataBlockSize_b - srcStart);
+                    if (!target->copyFrom(source, srcStart, blockStart + copied, chunk)) {
+                        // the DataBlockList may already reference the block, save it with what was copied
+                        dstBlocks.push_back(std::move(target));
+                        finishWrite(dst, std::max(dstSize, dstPos + done), dstBlocks, changedMetaBlocks);
+                        return false;
+                    }
+                    copied += chunk;
+                }
+            }
+            done += blockBytes;
+            dstBlocks.push_back(std::move(target));
+        }
+        if (!saveDataUnit(dstBlocks, reserved)) {
+            // the lost DataBlocks must not become readable, keep the old size
+            finishWrite(dst, dstSize, dstBlocks, changedMetaBlocks);
+            return false;
+        }
+    }
+    return finishWrite(dst, dstPos + n, dstBlocks, changedMetaBlocks);
+}
+
+std::future<bool> FS::readAsync(uint32_t fileHandle, char* target, uint32_t pos, std::size_t n) {
+    // std::function must be copyable, std::promise is not
+    std::shared_ptr<std::promise<bool>> promise(new std::promise<bool>());
+    readAsync(fileHandle, target, pos, n, [promise](bool result) {
+        promise->set_value(result);
+    });
+    return promise->get_future();
+}
+
+void FS::readAsync(uint32_t fileHandle, char* target, uint32_t pos, std::size_t n, std::function<void(bool)> callback) {
+    if (!ioQueue.submit(fileHandle, [this, fileHandle, target, pos, n, callback]() {
+            callback(read(fileHandle, target, pos, n));
+        })) {
+        std::cout << "fs: error - async read after umount" << std::endl;
+        callback(false);
+    }
+}
+
+std::future<bool> FS::writeAsync(uint32_t fileHandle, const char* source, uint32_t pos, std::size_t n) {
+    std::shared_ptr<std::promise<bool>> promise(new std::promise<bool>());
+    writeAsync(fileHandle, source, pos, n, [promise](bool result) {
+        promise->set_value(result);
+    });
+    return promise->get_future();
+}
+
+void FS::writeAsync(uint32_t fileHandle, const char* source, uint32_t pos, std::size_t n, std::function<void(bool)> callback) {
+    if (!ioQueue.submit(fileHandle, [this, fileHandle, source, pos, n, callback]() {
+            callback(write(fileHandle, source, pos, n));
+        })) {
+        std::cout << "fs: error - async write after umount" << std::endl;
+        callback(false);
+    }
+}
+
+std::future<bool> FS::flushAsync(uint32_t handle) {
+    std::shared_ptr<std::promise<bool>> promise(new std::promise<bool>());
+    flushAsync(handle, [promise](bool result) {
+        promise->set_value(result);
+    });
+    return promise->get_future();
+}
+
+void FS::flushAsync(uint32_t handle, std::function<void(bool)> callback) {
+    if (!ioQueue.submit(handle, [this, handle, callback]() {
+            callback(flushFile(handle));
+        })) {
+        std::cout << "fs: error - async flush after umount" << std::endl;
+        callback(false);
     }
-    removeDataBlocks(file, oldNumberOfBlocks - newNumberOfBlocks);
-    file->getPrimaryINode().setInternalSize_b(size);
-    saveBlock(file->getPrimaryINode());
-    return true;
 }
 
 void FS::switchNonInline(File *file) {
-    // switching requires 1 new Inode, 1 new DataBlockList, 1 new DataBlock
-    if (usedBlocks + 3 > logSize) {
+    // switching requires 1 new Inode, 1 new DataBlock (new files are extent-mapped, no DataBlockList)
+    if (!reserveBlocks(file->getReservedBlocks(), 2)) {
         std::cout << "fs: write: cannot write, fs is too full for non-inline switch of file " << file->getPrimaryINode().getId() << std::endl;
         return;
     }
     // this block will hold the currently inlined data
-    std::unique_ptr<DataBlock> newDataBlock(new DataBlock(getNextBlockID()));
+    std::unique_ptr<DataBlock> newDataBlock(new DataBlock(getNextBlockID(), dataBlockSize_b));
     std::list<Block*> changedBlocks = file->convertToNonInline(std::move(newDataBlock));
     // save blocks
     for (Block *block : changedBlocks) {
-        saveBlock(*block);
+        saveBlock(*block, file->getReservedBlocks());
     }
 }
 
 bool FS::addDataBlock(File *file, std::unordered_map<uint32_t, Block*> &changedMetaBlocks) {
     // before adding a DataBlock, check the file can tolerate one more + enough blocks are free (for inode, new block, new list)
-    if (usedBlocks + 3 > logSize) {
+    // a fragmented extent-mapped file switches to DataBlockLists first, which needs one new block per list
+    if (!reserveBlocks(file->getReservedBlocks(), 3 + file->getListConversionBlocks())) {
         std::cout << "fs: write: cannot write, fs is too full to add one additional data block to file " << file->getPrimaryINode().getId() << std::endl;
         return false;
     }
@@ -1489,11 +2898,11 @@ bool FS::addDataBlock(File *file, std::unordered_map<uint32_t, Block*> &changedM
         return false;
     }
     // handle previously cached block first
-    if (file->cachedDataBlockIsDirty()) {
-        saveBlock(*(file->releaseCachedDataBlock().get()));
+    if (file->cachedDataBlockIsDirty() && !saveBlock(*(file->releaseCachedDataBlock().get()), file->getReservedBlocks())) {
+        return false;
     }
     // alloc, then save
-    std::unique_ptr<DataBlock> newDataBlock(new DataBlock(getNextBlockID()));
+    std::unique_ptr<DataBlock> newDataBlock(new DataBlock(getNextBlockID(), dataBlockSize_b));
 
     std::list<Block*> changedBlocks = file->addDataBlock(std::move(newDataBlock)); // this also sets DataBlock as cached
     for (Block *block : changedBlocks) {
@@ -1504,25 +2913,30 @@ bool FS::addDataBlock(File *file, std::unordered_map<uint32_t, Block*> &changedM
     return true;
 }
 
-void FS::removeDataBlocks(File *file, std::size_t n) {
-    // this requires at least 1 free block (updated INode or DataBlockList)
-    if (usedBlocks + 1 > logSize) {
+bool FS::removeDataBlocks(File *file, std::size_t n) {
+    // this requires at least 1 free block (updated INode or DataBlockList), reserved by the caller
+    if (*file->getReservedBlocks() == 0) {
         std::cout << "fs: cannot remove DataBlock, this requires at least 1 free block as buffer, file " << file->getPrimaryINode().getId() << std::endl;
-        return;
+        return false;
     }
     // do not remove last datablock of file
     if (file->getNumberOfDataBlocks() <= n) {
         std::cout << "fs: error - invalid number of datablocks to remove, requested " << n << ", present in file " << file->getNumberOfDataBlocks()
                 << " file " << file->getPrimaryINode().getId() << std::endl;
-        return;
+        return true;
     }
     std::list<Block*> changedBlocks;
     for (std::size_t i = 0; i < n; ++i) {
+        uint32_t removedID = file->getDataBlockID(file->getNumberOfDataBlocks() - 1);
         addUnique<Block*>(changedBlocks, file->removeDataBlock());
+        // DataBlocks may still be used by clones
+        releaseBlock(removedID);
     }
+    bool saved = true;
     for (Block *block : changedBlocks) {
-        saveBlock(*block);
+        saved = saveBlock(*block, file->getReservedBlocks()) && saved;
     }
+    return saved;
 }
 
 } // SDI4FS
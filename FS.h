@@ -8,17 +8,28 @@
 #ifndef SDI4FS_FS_H
 #define	SDI4FS_FS_H
 
+#include <functional>
+#include <future>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "DataBlock.h"
 #include "DataBlockList.h"
+#include "DirEntry.h"
 #include "Directory.h"
 #include "File.h"
 #include "IDataBlockListCreator.h"
 #include "IDirectoryEntryListCreator.h"
 #include "INode.h"
+#include "IOQueue.h"
+#include "IOVec.h"
+#include "PathUtils.inc"
+#include "RWLock.h"
+#include "Snapshot.h"
 #include "StreamSelectorHeader.inc"
 
 namespace SDI4FS {
@@ -30,11 +41,28 @@ namespace SDI4FS {
  * Usage:
  * - Mount the filesystem by calling the constructor.
  * - Call the other methods to use the fs, the names should be self-explanatory.
+ *   Paths are passed as PathView, which wraps std::string and C strings without copying them.
  * - Call umount() to finish.
  *
+ * Read-only mounts: see isReadOnly.
+ *
+ * Thread safety:
+ * After the constructor returns, all methods may be called from multiple threads.
+ * Lookups (ls, readdir, stat, fileSize) and file I/O run in parallel, they share a filesystem-wide reader/writer lock.
+ * Namespace changes, openFile/closeFile and umount take this lock exclusively.
+ * Each open File has its own lock, held for read/write/truncate/flushFile, so I/O on different files runs in parallel.
+ * The allocator state (write_ptr, coldWritePtr, nextBlockID, usedBlocks) and the device stream each have a mutex,
+ * held only for short sections. Lock order: fs -> File -> allocator -> device.
+ *
+ * Async I/O:
+ * readAsync, writeAsync and flushAsync queue the request and return immediately.
+ * The requests are executed by internal I/O threads (started on first use), completion is signalled through
+ * a std::future or a callback. Requests for the same handle complete in submission order, any number may be queued.
+ * Requests for different handles run in parallel. Callbacks run on an I/O thread and must not call umount().
+ * umount() waits for all queued requests.
+ *
  * File system consistency is guaranteed under the following circumstances (logic AND):
  *
- * - Methods are only called from one thread.
  * - After using the filesystem umount() is called
  * - Nothing else is called after umount()
  * - No crashes
@@ -49,8 +77,47 @@ public:
     /**
      * Creates (mounts) the filesystem.
      * @param dev device
+     * @param readOnly true to mount read-only, see isReadOnly
+     */
+    FS(STREAM &dev, bool readOnly = false);
+
+    /**
+     * Mounts a read-only view of a snapshot of another (mounted) fs, see createSnapshot.
+     * The view copies the frozen bmap at construction and is independent of origin afterwards,
+     * but the snapshot must not be released before the view is unmounted (the gc would reclaim its blocks).
+     * @param dev a second stream on the device of origin (the stream of origin is in use by origin)
+     * @param origin the fs the snapshot was taken from
+     * @param snapshotID the snapshot
      */
-    FS(STREAM &dev);
+    FS(STREAM &dev, FS &origin, uint32_t snapshotID);
+
+    /**
+     * Returns true, iff the fs is mounted read-only.
+     * A read-only fs never writes to the device, not even the header (mount/umount state) or the bmap.
+     * If the last umount was missed, the bmap is reconstructed in memory only (on every read-only mount).
+     * All modifying methods (mkdir, rmdir, rename, touch, rm, link, write, writev, truncate) fail.
+     * So any number of read-only instances (threads or processes) can share one image, as long as nobody mounts it writable.
+     * @return true, iff read-only
+     */
+    bool isReadOnly() const;
+
+    /**
+     * Takes a point-in-time snapshot of the whole fs.
+     * Open files are flushed first, so the snapshot contains all writes that returned before this call.
+     * Creation is cheap: the bmap is copied lazily, page by page, when the live fs changes it.
+     * As long as the snapshot exists, the gc keeps all blocks it references, so a view (see constructor)
+     * can be mounted at any time, while the live fs keeps changing.
+     * Snapshots are not persistent, umount releases all of them.
+     * @return snapshot id or zero (on error)
+     */
+    uint32_t createSnapshot();
+
+    /**
+     * Releases a snapshot, the gc may reclaim its blocks afterwards.
+     * @param snapshotID the snapshot
+     * @return true, iff released (false if there is no such snapshot)
+     */
+    bool releaseSnapshot(uint32_t snapshotID);
 
     /**
      * Unmounts the filesystem.
@@ -64,7 +131,7 @@ public:
      * @param absolutePath absolute (!) path, including new directory
      * @return true, iff successful
      */
-    bool mkdir(std::string absolutePath);
+    bool mkdir(PathView absolutePath);
 
     /**
      * Removes the directory with the given path.
@@ -72,7 +139,7 @@ public:
      * @param absolutePath absolute (!) path, including directory to remove
      * @return true, iff successful
      */
-    bool rmdir(std::string absolutePath);
+    bool rmdir(PathView absolutePath);
 
     /**
      * Renames (moves) a hardlink.
@@ -80,14 +147,14 @@ public:
      * @param destPath absolute, new path
      * @return true, iff successful
      */
-    bool rename(std::string sourcePath, std::string destPath);
+    bool rename(PathView sourcePath, PathView destPath);
 
     /**
      * Creates an empty (regular) file.
      * @param absolutePath absolute path, including new file
      * @return true, iff successful
      */
-    bool touch(std::string absolutePath);
+    bool touch(PathView absolutePath);
 
     /**
      * Lists the content of a directory.
@@ -106,7 +173,40 @@ public:
      * @param result the listing, one line per file
      * @return true, iff successful
      */
-    bool ls(std::string absolutePath, std::list<std::string> &result);
+    bool ls(PathView absolutePath, std::list<std::string> &result);
+
+    /**
+     * Opens a directory for listing with readdir/readdirplus.
+     * Cursors need no cleanup, dropping them is fine.
+     * @param absolutePath the absolute path to the directory
+     * @param cursor will be set to the first entry of the directory
+     * @return true, iff successful
+     */
+    bool openDir(PathView absolutePath, ReaddirCursor &cursor);
+
+    /**
+     * Returns the next batch of entries (name, id, type) of a directory opened with openDir,
+     * and advances the cursor. Only one DirectoryEntryList is held in memory at a time,
+     * so this works in bounded memory regardless of the size of the directory.
+     * Entries are returned in the same order as by ls, all dotfiles included.
+     * Removing entries (for example the ones just returned) between calls does not make the cursor skip others.
+     * Call repeatedly until cursor.isAtEnd() returns true.
+     * @param cursor the cursor, as returned by openDir
+     * @param batch cleared, then filled with up to maxEntries entries
+     * @param maxEntries maximum number of entries to return, must not be zero
+     * @return true, iff successful
+     */
+    bool readdir(ReaddirCursor &cursor, std::vector<DirEntry> &batch, std::size_t maxEntries);
+
+    /**
+     * Like readdir, but additionally fills the stat field of every entry.
+     * Requires reading the INode of every returned entry.
+     * @param cursor the cursor, as returned by openDir
+     * @param batch cleared, then filled with up to maxEntries entries
+     * @param maxEntries maximum number of entries to return, must not be zero
+     * @return true, iff successful
+     */
+    bool readdirplus(ReaddirCursor &cursor, std::vector<DirEntry> &batch, std::size_t maxEntries);
 
     /**
      * Removes a hardlink to a file.
@@ -115,7 +215,7 @@ public:
      * @param absolutePath absolute path to file
      * @return true, iff successful
      */
-    bool rm(std::string absolutePath);
+    bool rm(PathView absolutePath);
 
     /**
      * Creates a new hardlink to a file.
@@ -123,21 +223,52 @@ public:
      * @param targetPath absolute Path of the existing file
      * @return true, iff successful
      */
-    bool link(std::string sourcePath, std::string targetPath);
+    bool link(PathView sourcePath, PathView targetPath);
+
+    /**
+     * Creates a copy of a file that shares all DataBlocks with the original (reflink).
+     * Only the FileINode and the DataBlockLists are written, so this takes one block per 4 MiB of content
+     * instead of copying the content. Shared DataBlocks are reference counted, writes to either file
+     * copy the affected DataBlock first (copy-on-write), rm and truncate free a DataBlock only when its last reference goes.
+     * If the source is open, it is flushed first.
+     * @param sourcePath absolute path of the existing file
+     * @param targetPath absolute path of the new file, must not exist
+     * @return true, iff successful
+     */
+    bool clone(PathView sourcePath, PathView targetPath);
+
+    /**
+     * Returns the metadata of the file or directory with the given path.
+     * Only the primary INode is read, never any DataBlockLists or DirectoryEntryLists.
+     * @param absolutePath absolute path of the file or directory
+     * @param stat will be filled with the metadata
+     * @return true, iff successful
+     */
+    bool stat(PathView absolutePath, StatInfo &stat);
+
+    /**
+     * Returns the metadata of the file or directory with the given primary INode id, see stat.
+     * Reads the 20 byte INode header, plus the DirectoryEntryList ids of non-inlined directories
+     * (to calculate the disk size). Both are located in the primary INode block.
+     * @param id block id of the primary INode, as returned by readdir
+     * @param stat will be filled with the metadata
+     * @return true, iff successful
+     */
+    bool statById(uint32_t id, StatInfo &stat);
 
     /**
      * Convenience function, returns the size (bytes) of the file with the given path.
      * @param absolutePath absolute path of the file
      * @return size in bytes, or zero (ambiguous!)
      */
-    uint32_t fileSize(std::string absolutePath);
+    uint32_t fileSize(PathView absolutePath);
 
     /**
      * Opens the file denoted by the given path.
      * @param absolutePath the absolute path of the file to open
      * @return a file descriptor (handle) or zero (on error)
      */
-    uint32_t openFile(std::string absolutePath);
+    uint32_t openFile(PathView absolutePath);
 
     /**
      * Closes the file with the given handle.
@@ -152,8 +283,9 @@ public:
      * This forces pending metadata to be written to disk immediately,
      * preserving the data from loss in case of crashes etc.
      * @param handle the file handle
+     * @return true, iff successful
      */
-    void flushFile(uint32_t handle);
+    bool flushFile(uint32_t handle);
 
     /**
      * Reads the requested number of bytes from the requested absolute position in the file denoted by fileHandle.
@@ -181,6 +313,30 @@ public:
      */
     bool write(uint32_t fileHandle, const char* source, uint32_t pos, std::size_t n);
 
+    /**
+     * Vectored read, like read, but scatters the data over the given fragments (in order).
+     * The byte range starts at pos, its length is the total length of all fragments.
+     * Every DataBlock in the range is loaded once and copied directly into the fragments.
+     * @param fileHandle valid file descriptor
+     * @param iov the fragments to copy the data into
+     * @param iovcnt number of fragments
+     * @param pos absolute position within the file (bytes)
+     * @return true, iff successful
+     */
+    bool readv(uint32_t fileHandle, const IOVec *iov, std::size_t iovcnt, uint32_t pos);
+
+    /**
+     * Vectored write, like write, but gathers the data from the given fragments (in order).
+     * The byte range starts at pos, its length is the total length of all fragments.
+     * Every DataBlock in the range is loaded once and copied directly from the fragments.
+     * @param fileHandle valid file descriptor
+     * @param iov the fragments to read the data from (not modified)
+     * @param iovcnt number of fragments
+     * @param pos absolute position within file (bytes)
+     * @return true, iff successful
+     */
+    bool writev(uint32_t fileHandle, const IOVec *iov, std::size_t iovcnt, uint32_t pos);
+
     /**
      * Truncates the file denoted by the given handle to the given size.
      * After this operation returns true, the length of the file is exactly the given number of bytes.
@@ -192,6 +348,82 @@ public:
      */
     bool truncate(uint32_t fileHandle, uint32_t size);
 
+    /**
+     * Copies n bytes from one open file to another (or within one file), like read + write, but without caller buffers.
+     * Source DataBlocks are read in log order and copied directly into the destination DataBlocks,
+     * which are saved in batches of SDI4FS_COPY_BATCH_BLOCKS with one log reservation each.
+     * If both positions are DataBlock-aligned, every destination block is a copy of one source block
+     * and existing destination blocks are never read.
+     * The destination size afterwards is dstPos + n, like write.
+     * @param srcHandle file descriptor of the source file
+     * @param srcPos absolute position within the source file, the range must be within the file
+     * @param dstHandle file descriptor of the destination file, may be srcHandle if the ranges do not overlap
+     * @param dstPos absolute position within the destination file, must be smaller than or equal to its size
+     * @param n number of bytes to copy
+     * @return true, iff successful
+     */
+    bool copyRange(uint32_t srcHandle, uint32_t srcPos, uint32_t dstHandle, uint32_t dstPos, uint32_t n);
+
+    /**
+     * Asynchronous read, see read and the class comment.
+     * The target buffer must stay valid until the request completes.
+     * @param fileHandle valid file descriptor
+     * @param target buffer to copy the data into
+     * @param pos absolute position within the file (bytes)
+     * @param n number of bytes to copy
+     * @return future for the result of read
+     */
+    std::future<bool> readAsync(uint32_t fileHandle, char* target, uint32_t pos, std::size_t n);
+
+    /**
+     * Asynchronous read, see read and the class comment.
+     * The target buffer must stay valid until the request completes.
+     * @param fileHandle valid file descriptor
+     * @param target buffer to copy the data into
+     * @param pos absolute position within the file (bytes)
+     * @param n number of bytes to copy
+     * @param callback called with the result of read, on an I/O thread
+     */
+    void readAsync(uint32_t fileHandle, char* target, uint32_t pos, std::size_t n, std::function<void(bool)> callback);
+
+    /**
+     * Asynchronous write, see write and the class comment.
+     * The source buffer must stay valid until the request completes.
+     * @param fileHandle valid file descriptor
+     * @param source source to read data from
+     * @param pos absolute position within file (bytes)
+     * @param n number of bytes to copy
+     * @return future for the result of write
+     */
+    std::future<bool> writeAsync(uint32_t fileHandle, const char* source, uint32_t pos, std::size_t n);
+
+    /**
+     * Asynchronous write, see write and the class comment.
+     * The source buffer must stay valid until the request completes.
+     * @param fileHandle valid file descriptor
+     * @param source source to read data from
+     * @param pos absolute position within file (bytes)
+     * @param n number of bytes to copy
+     * @param callback called with the result of write, on an I/O thread
+     */
+    void writeAsync(uint32_t fileHandle, const char* source, uint32_t pos, std::size_t n, std::function<void(bool)> callback);
+
+    /**
+     * Asynchronous flushFile, see flushFile and the class comment.
+     * Completes after all requests queued before it for the same handle.
+     * @param handle the file handle
+     * @return future for the result of flushFile
+     */
+    std::future<bool> flushAsync(uint32_t handle);
+
+    /**
+     * Asynchronous flushFile, see flushFile and the class comment.
+     * Completes after all requests queued before it for the same handle.
+     * @param handle the file handle
+     * @param callback called with the result of flushFile, on an I/O thread
+     */
+    void flushAsync(uint32_t handle, std::function<void(bool)> callback);
+
     virtual ~FS();
 private:
     /**
@@ -199,16 +431,27 @@ private:
      */
     STREAM &dev;
 
+    /**
+     * True, iff mounted read-only. Never changes after construction.
+     */
+    const bool readOnly;
+
     /**
      * FS size in bytes.
      */
     uint64_t size_b;
 
     /**
-     * Logic position in the log where to write the next block.
+     * Logic position in the log where to write the next hot block (see isColdBlock).
      */
     uint32_t write_ptr;
 
+    /**
+     * Logic position in the log where to write the next cold block (see isColdBlock).
+     * A second log head, so long-lived file data is not interleaved with frequently rewritten metadata.
+     */
+    uint32_t coldWritePtr;
+
     /**
      * Next (currently free) block ID to use for new blocks.
      */
@@ -224,6 +467,16 @@ private:
      */
     uint64_t bmapSize_b;
 
+    /**
+     * Feature bits from the header (SDI4FS_FEATURE_*), fixed at format time.
+     */
+    uint32_t features;
+
+    /**
+     * Position in bytes where the summary area starts (only with SDI4FS_FEATURE_OUT_OF_LINE_HEADERS).
+     */
+    uint64_t summaryStart_bptr;
+
     /**
      * Position in bytes where the log starts.
      */
@@ -239,11 +492,66 @@ private:
      */
     uint32_t usedBlocks;
 
+    /**
+     * Content size of DataBlocks in bytes, SDI4FS_MAX_BYTES_PER_ALIGNED_DATABLOCK with out-of-line headers,
+     * SDI4FS_MAX_BYTES_PER_DATABLOCK otherwise.
+     */
+    uint32_t dataBlockSize_b;
+
+    /**
+     * One entry of the summary area, layout as on disk (see sdi4fs_spec, SUMMARY).
+     */
+    struct SummaryEntry {
+        /**
+         * The blockID, zero for free slots.
+         */
+        uint32_t id;
+
+        /**
+         * The write time.
+         */
+        uint32_t writeTime;
+
+        /**
+         * The write sequence number (see nextSequence), SDI4FS_SUMMARY_COLD_BIT is set for blocks of the cold log head.
+         */
+        uint64_t sequence;
+    };
+
+    static_assert(sizeof (SummaryEntry) == SDI4FS_SUMMARY_ENTRY_SIZE, "in-memory SummaryEntry must match on-disk layout");
+
+    /**
+     * Copy of the summary block of segment summaryCacheSegment, so scans over the log (gc, bmap reconstruction)
+     * read one summary block per segment instead of one entry per slot. Written through, guarded by devLock.
+     */
+    SummaryEntry summaryCache[SDI4FS_SLOTS_PER_SEGMENT];
+
+    /**
+     * Number of the segment in summaryCache, UINT32_MAX if empty.
+     */
+    uint32_t summaryCacheSegment;
+
+    /**
+     * Sequence number of the next summary entry (only with out-of-line headers), guarded by devLock.
+     * Strictly increasing with every saved block instance, so unlike the write time it orders all instances of a block.
+     */
+    uint64_t nextSequence;
+
     /**
      * In-Memory block map.
+     * While mounted, entries are only accessed with loadBMapEntry/storeBMapEntry (AtomicUtils.inc),
+     * so lookups need no lock. Writers hold allocLock.
      */
     uint32_t *bmap;
 
+    /**
+     * In-memory INode type map, 2 bits per block id (same indexing as bmap).
+     * Caches the result of peekINodeType, so type checks during path traversal need no I/O.
+     * Zero means unknown (not yet peeked, not an INode or freed), otherwise the INode type.
+     * Not persisted, filled on demand (and during bmap reconstruction).
+     */
+    uint8_t *inodeTypes;
+
     /**
      * Used during fs mount, true iff the copy of the bmap on the disk is valid.
      * (last umount was successful)
@@ -265,6 +573,67 @@ private:
      */
     std::unordered_map<uint32_t, std::unique_ptr<File>> openFiles;
 
+    /**
+     * Filesystem-wide reader/writer lock, see class comment.
+     * Shared: lookups and file I/O. Exclusive: everything that modifies the namespace or openFiles.
+     */
+    RWLock fsLock;
+
+    /**
+     * Guards the allocator state: write_ptr, coldWritePtr, nextBlockID, usedBlocks and all writes to the bmap.
+     */
+    std::mutex allocLock;
+
+    /**
+     * Log slots handed out by reserveLogSlot, but not yet published in the bmap by saveBlock.
+     * The gc must skip them. Guarded by allocLock.
+     */
+    std::unordered_set<uint32_t> reservedSlots;
+
+    /**
+     * Log slots reserved by open files (see reserveBlocks), but not yet taken by the gc.
+     * Counts as used for everybody else. Guarded by allocLock.
+     */
+    uint32_t reservedBlocks;
+
+    /**
+     * Guards dev (a seek must not be separated from its read/write) and inodeTypes.
+     */
+    std::mutex devLock;
+
+    /**
+     * Executes the async API requests, keyed by file handle.
+     */
+    IOQueue ioQueue;
+
+    /**
+     * Live snapshots by id. Guarded by allocLock (snapshots are updated with every bmap change).
+     */
+    std::unordered_map<uint32_t, std::unique_ptr<Snapshot>> snapshots;
+
+    /**
+     * Id of the last created snapshot. Guarded by allocLock.
+     */
+    uint32_t lastSnapshotID;
+
+    /**
+     * Number of log slots that hold no live block, but are kept by the gc for a snapshot (see pinnedBySnapshot).
+     * Not part of usedBlocks, but just as unavailable for new blocks. Guarded by allocLock.
+     */
+    uint32_t pinnedBlocks;
+
+    /**
+     * DataBlock id -> number of additional references, for DataBlocks shared by clones (see clone).
+     * Blocks with a single reference are not listed. Guarded by allocLock.
+     * Saved to a hidden file on umount (see saveSharedBlocks), rebuilt by the bmap reconstruction.
+     */
+    std::unordered_map<uint32_t, uint32_t> sharedBlocks;
+
+    /**
+     * Id of the FileINode that holds the saved sharedBlocks, zero if none.
+     */
+    uint32_t sharedBlocksTable;
+
     /**
      * Reads the header info from the block device.
      * Gets basic data and verifies this is actually a sdi4fs partition.
@@ -272,6 +641,54 @@ private:
      */
     bool readHeader();
 
+    /**
+     * Prints an error and returns true, iff the fs is mounted read-only.
+     * Called at the start of every modifying method.
+     * @param operation name of the rejected method, for the message
+     * @return true, iff the operation must be rejected
+     */
+    bool rejectReadOnly(const char *operation);
+
+    /**
+     * Implements the constructors.
+     * @param origin fs to copy the bmap from, or NULL to load/reconstruct it from dev
+     * @param snapshotID snapshot of origin to copy (only if origin is set)
+     */
+    void mount(FS *origin, uint32_t snapshotID);
+
+    /**
+     * Copies the frozen bmap of a snapshot, for mounting a view.
+     * @param snapshotID the snapshot
+     * @param target bmap of the view, logSize entries
+     * @param snapshotUsedBlocks set to the number of used blocks of the snapshot
+     * @return true, iff the snapshot exists
+     */
+    bool copySnapshotBMap(uint32_t snapshotID, uint32_t *target, uint32_t &snapshotUsedBlocks);
+
+    /**
+     * Changes a live bmap entry, first preserving the old value for all snapshots.
+     * Counts the old log slot as pinned, if a snapshot still references it.
+     * Caller must hold allocLock.
+     * @param id block id
+     * @param logPtr new log position of the block, zero to remove it
+     */
+    void setBMapEntry(uint32_t id, uint32_t logPtr);
+
+    /**
+     * Returns true, iff a snapshot references the given block at the given log position.
+     * Caller must hold allocLock.
+     * @param id block id
+     * @param logPtr log position
+     * @return true, iff the log slot must be kept for a snapshot
+     */
+    bool pinnedBySnapshot(uint32_t id, uint32_t logPtr);
+
+    /**
+     * Recalculates pinnedBlocks from the live bmap and all snapshots, after a snapshot was released.
+     * Caller must hold allocLock.
+     */
+    void countPinnedBlocks();
+
     /**
      * Calculates parameters critical for fs operation,
      * included, but not limited to (TM):
@@ -297,6 +714,8 @@ private:
 
     /**
      * Returns the latest location of a block in the log.
+     * Lock-free. Without allocLock, the result may be outdated by the time it is used
+     * (block moved and old slot reused), so readers must verify the block id they find there.
      * @param id the blockID
      * @return the address of the block, if known. zero if not in log/unknown/invalid
      */
@@ -309,6 +728,20 @@ private:
      */
     std::unique_ptr<Directory> loadDirectory(uint32_t id);
 
+    /**
+     * Loads only the primary DirectoryINode with the given id, but none of its DirectoryEntryLists.
+     * @param id the id of the primary directoryINode
+     * @return unique_ptr to the INode on success, to nullptr otherwise
+     */
+    std::unique_ptr<DirectoryINode> loadDirectoryINode(uint32_t id);
+
+    /**
+     * Loads only the primary FileINode with the given id, but none of its DataBlockLists.
+     * @param id the id of the primary fileINode
+     * @return unique_ptr to the INode on success, to nullptr otherwise
+     */
+    std::unique_ptr<FileINode> loadFileINode(uint32_t id);
+
     /**
      * Loads the DirectoryEntryList with the given id.
      * @param id the blockID
@@ -316,6 +749,17 @@ private:
      */
     std::unique_ptr<DirectoryEntryList> loadDirEntryList(uint32_t id);
 
+    /**
+     * Reads the latest version of the given block from the log by calling the constructor T(STREAM&).
+     * Looks up the block without locking, then verifies the block id at that location.
+     * If the block was moved meanwhile (and its old slot reused), the lookup is repeated.
+     * @param id the blockID
+     * @param what name of the block type, for error messages
+     * @return unique_ptr to the new block, to nullptr otherwise
+     */
+    template <typename T>
+    std::unique_ptr<T> readBlock(uint32_t id, const char *what);
+
     /**
      * Load the File (fs internal logic object) for the given primary FileINode id.
      * @param id the id of the primary fileINode
@@ -337,12 +781,35 @@ private:
      */
     std::unique_ptr<DataBlock> loadDataBlock(uint32_t id);
 
+    /**
+     * Loads consecutive DataBlocks of a file, in the order of their log positions
+     * (blocks written together are read with sequential device accesses).
+     * @param file the file
+     * @param firstBlockNo number of the first DataBlock, starts at zero
+     * @param blocks filled with the DataBlocks firstBlockNo, firstBlockNo + 1, ..., its size is the number of blocks to load
+     * @return true, iff all blocks were loaded
+     */
+    bool loadDataBlocks(File &file, uint32_t firstBlockNo, std::vector<std::unique_ptr<DataBlock>> &blocks);
+
     /**
      * (Re-)Generates the BMap from the contents of the Log.
-     * Does two complete swipes of the Log: O(n)
+     * Does two complete swipes of the Log (one swipe of the summary area with out-of-line headers): O(n)
      */
     void reconstructBMap();
 
+    /**
+     * Finds the latest instance of every block in the summary area (only with out-of-line headers), single pass.
+     * Sets bmap, usedBlocks, write_ptr, coldWritePtr, nextBlockID and nextSequence.
+     */
+    void scanSummary();
+
+    /**
+     * Finds the latest instance of every block from the in-slot block headers, first estimates write_ptr,
+     * then resolves equal write times by the log position relative to it.
+     * Sets bmap, usedBlocks, write_ptr and nextBlockID.
+     */
+    void scanLog();
+
     /**
      * Recursive, depth-first traversal function of the bmap-reconstruction (step 3)
      * @param bmapFilter the bmap filter to mark blocks as reachable
@@ -350,15 +817,66 @@ private:
      */
     void recursiveRecovery(bool *bmapFilter, Directory &dir);
 
+    /**
+     * Reads the header (blockID, write time) of the block in the given log slot.
+     * With out-of-line headers, the header is read from the summary area, otherwise from the slot itself.
+     * Caller must hold devLock.
+     * @param slot logic pointer to the slot
+     * @param id set to the blockID, zero for free slots
+     * @param writeTime set to the write time
+     */
+    void readSlotHeader(uint32_t slot, uint32_t *id, uint32_t *writeTime);
+
+    /**
+     * Marks the given log slot as free, by nulling the blockID in its header.
+     * Caller must hold devLock.
+     * @param slot logic pointer to the slot
+     */
+    void clearSlot(uint32_t slot);
+
+    /**
+     * Writes the summary entry for a block that was just saved to the given slot.
+     * Does nothing without out-of-line headers (the block wrote its own header).
+     * Caller must hold devLock.
+     * @param slot logic pointer to the slot
+     * @param block the saved block
+     * @param cold true, iff the slot was reserved at the cold log head (see isColdBlock)
+     * @param continued true, iff the previous call wrote the entry of slot - 1 (appends without seeking)
+     */
+    void writeSummaryEntry(uint32_t slot, Block &block, bool cold, bool continued = false);
+
+    /**
+     * Returns the cached summary entry of the given slot, reads the summary block of its segment if necessary.
+     * Only with out-of-line headers, caller must hold devLock.
+     * @param slot logic pointer to the slot
+     * @return the cached entry
+     */
+    SummaryEntry& getSummaryEntry(uint32_t slot);
+
     /**
      * Runs the garbage collection on-demand to find a allocable block in the log.
      * Returns a logic pointer to the next free position in the log.
-     * Advances the write_ptr during search, but does *not* advance the pointer
-     * when a result was found, so on success the returned value should be write_ptr.
+     * Advances the given log head during search, but does *not* advance the pointer
+     * when a result was found, so on success the returned value should be the head.
      * Also does not change the number of used blocks.
+     * A found slot is taken from the given reservation, without one only unreserved slots can be used.
+     * Caller must hold allocLock and devLock.
+     * @param head the log head to search from, write_ptr or coldWritePtr
+     * @param reserved the reservation of the caller (see reserveBlocks), may be NULL
      * @return logic pointer to free block in log, or zero iff full
      */
-    uint32_t gc();
+    uint32_t gc(uint32_t &head, uint32_t *reserved);
+
+    /**
+     * Returns true, iff the given block is cold and belongs to the log head coldWritePtr.
+     * Cold blocks are DataBlocks that are written for the first time (bulk file data, which usually stays).
+     * All other blocks (INodes, lists, rewritten DataBlocks) are hot and written at write_ptr.
+     * Only with out-of-line headers, otherwise all blocks are hot (see scanLog).
+     * Caller must hold allocLock.
+     * @param block the block to save
+     * @return true, iff cold
+     */
+    bool isColdBlock(Block &block);
 
     /**
      * Returns a new (currently unused) blockID
@@ -369,8 +887,41 @@ private:
     /**
      * Saves the given Block to disk.
      * @param block block to save
+     * @param reserved the reservation to take the log slot from (see reserveBlocks), NULL for exclusive callers
+     * @return true, iff saved (false if the log is full)
+     */
+    bool saveBlock(Block &block, uint32_t *reserved = NULL);
+
+    /**
+     * Saves the given Blocks to disk, like saveBlock, but reserves all log slots at once
+     * and writes them in one device section (consecutive slots are one sequential write).
+     * If the log runs full, only the first blocks are saved.
+     * @param blocks blocks to save
+     * @param reserved the reservation to take the log slots from (see reserveBlocks), NULL for exclusive callers
+     * @return true, iff all blocks were saved
      */
-    void saveBlock(Block &block);
+    bool saveBlocks(const std::vector<Block*> &blocks, uint32_t *reserved = NULL);
+
+    /**
+     * Saves the staged DataBlocks of a streaming write as one data unit (see saveBlocks),
+     * then clears the unit (also if it could not be saved completely, the rest is lost).
+     * @param unit the DataBlocks, in file order
+     * @param reserved the reservation to take the log slots from (see reserveBlocks)
+     * @return true, iff all DataBlocks were saved
+     */
+    bool saveDataUnit(std::vector<std::unique_ptr<DataBlock>> &unit, uint32_t *reserved);
+
+    /**
+     * Ends a (possibly partial) write: sets the file size, saves the staged DataBlocks and then the changed meta blocks.
+     * Used on every exit path of writevImpl and copyRange, so the saved DataBlockLists/INode always reference the saved DataBlocks.
+     * If the staged DataBlocks cannot be saved, the file keeps its old size.
+     * @param file the file
+     * @param size_b the new file size
+     * @param unit the staged DataBlocks, in file order
+     * @param changedMetaBlocks the changed meta blocks of the write
+     * @return true, iff all blocks were saved
+     */
+    bool finishWrite(File &file, uint32_t size_b, std::vector<std::unique_ptr<DataBlock>> &unit, std::unordered_map<uint32_t, Block*> &changedMetaBlocks);
 
     /**
      * Frees all disk space used for the given block,
@@ -379,23 +930,190 @@ private:
      */
     void freeBlock(uint32_t id);
 
+    /**
+     * Drops one reference to the given block, frees it (see freeBlock) iff this was the last reference.
+     * Only DataBlocks can have more than one reference (see clone).
+     * @param id blockID
+     */
+    void releaseBlock(uint32_t id);
+
+    /**
+     * Adds one reference to the given DataBlock.
+     * @param id blockID
+     */
+    void shareBlock(uint32_t id);
+
+    /**
+     * Drops one reference to the given DataBlock, unless this is the last one.
+     * A writer that gets true must not modify the block, but write a copy instead.
+     * @param id blockID
+     * @return true, iff the block is shared (and the reference was dropped)
+     */
+    bool unshareBlock(uint32_t id);
+
+    /**
+     * Loads the sharedBlocks table saved by the last umount.
+     * Only called while mounting with a valid bmap.
+     */
+    void loadSharedBlocks();
+
+    /**
+     * Replaces the saved sharedBlocks table (if any) with the current content of sharedBlocks.
+     * Only called while unmounting, before the bmap is saved.
+     * @return true, iff successful. Otherwise the next mount must rebuild the table
+     */
+    bool saveSharedBlocks();
+
     /**
      * Traverses the given path to find the parent directory of the given path.
      * The given object (last part of the path) does *not* need to exist for this.
-     * @param absolutePath the absolute path
-     * @return unique_ptr to the parent directory, or to nullptr if non-existent or invalid path
+     * The root dir is its own parent.
+     * @param path the resolved absolute path
+     * @return unique_ptr to the parent directory, or to nullptr if non-existent
      */
-    std::unique_ptr<Directory> searchParent(std::string absolutePath);
+    std::unique_ptr<Directory> searchParent(const ResolvedPath &path);
 
     /**
      * Peeks at the type field of the on-disk INode with the given id without fully loading it.
+     * Answered from the INode type map if possible, only reads from the device on the first access.
      * @param id blockID of an INode
      * @return inode type, undefined for non-INode ids
      */
     uint8_t peekINodeType(uint32_t id);
 
+    /**
+     * Stores the type of the given INode in the INode type map.
+     * Only SDI4FS_INODE_TYPE_DIR and SDI4FS_INODE_TYPE_REGULARFILE are cached,
+     * zero marks the entry as unknown. Caller must hold devLock.
+     * @param id the blockID of the INode
+     * @param type the INode type, or zero
+     */
+    void setINodeType(uint32_t id, uint8_t type);
+
+    /**
+     * Implements readdir and readdirplus.
+     * @param cursor the cursor, as returned by openDir
+     * @param batch cleared, then filled with up to maxEntries entries
+     * @param maxEntries maximum number of entries to return
+     * @param withStat true to fill the stat field of every entry
+     * @return true, iff successful
+     */
+    bool readdirImpl(ReaddirCursor &cursor, std::vector<DirEntry> &batch, std::size_t maxEntries, bool withStat);
+
+    /**
+     * Implements openDir, caller must hold fsLock.
+     * @param absolutePath the absolute path to the directory
+     * @param cursor will be set to the first entry of the directory
+     * @return true, iff successful
+     */
+    bool openDirImpl(PathView absolutePath, ReaddirCursor &cursor);
+
+    /**
+     * Implements stat, caller must hold fsLock.
+     * @param absolutePath absolute path of the file or directory
+     * @param stat will be filled with the metadata
+     * @return true, iff successful
+     */
+    bool statImpl(PathView absolutePath, StatInfo &stat);
+
+    /**
+     * Implements statById, caller must hold fsLock.
+     * @param id block id of the primary INode
+     * @param stat will be filled with the metadata
+     * @return true, iff successful
+     */
+    bool statByIdImpl(uint32_t id, StatInfo &stat);
+
+    /**
+     * Implements flushFile, caller must hold fsLock and the lock of the File (or fsLock exclusively).
+     * @param file the open file
+     * @return true, iff successful
+     */
+    bool flushFileImpl(File &file);
+
+    /**
+     * Implements readv, caller must hold fsLock and the lock of the File (or fsLock exclusively).
+     * @param file the open file
+     * @param iov the fragments, filled in order
+     * @param iovcnt number of fragments
+     * @param pos the position in the file to start reading from
+     * @return true, iff successful
+     */
+    bool readvImpl(File &file, const IOVec *iov, std::size_t iovcnt, uint32_t pos);
+
+    /**
+     * Implements writev, caller must hold fsLock and the lock of the File (or fsLock exclusively).
+     * @param file the open file
+     * @param iov the fragments, written in order
+     * @param iovcnt number of fragments
+     * @param pos the position in the file to start writing at
+     * @return true, iff successful
+     */
+    bool writevImpl(File &file, const IOVec *iov, std::size_t iovcnt, uint32_t pos);
+
+    /**
+     * Reserves the next free slot in the log (running the gc as required) and advances the log head of the block.
+     * This is the only part of saveBlock that holds allocLock, the block itself is written afterwards.
+     * @param block the block to save, selects the log head (see isColdBlock)
+     * @param cold set to true, iff the slot was reserved at the cold log head
+     * @param reserved the reservation to take the slot from, may be NULL
+     * @return logic pointer to the reserved slot, or zero iff full
+     */
+    uint32_t reserveLogSlot(Block &block, bool *cold, uint32_t *reserved);
+
+    /**
+     * Returns true, iff at least the given number of blocks is free.
+     * Slots reserved by open files and slots that are being written do not count as free.
+     * Only for callers that hold fsLock exclusively, file I/O runs in parallel and must use reserveBlocks.
+     * @param n number of blocks
+     * @return true, iff n blocks are free
+     */
+    bool hasFreeBlocks(uint32_t n);
+
+    /**
+     * Makes sure that at least n log slots are reserved in the given reservation.
+     * Reserved slots count as used for everybody else, saveBlock takes one per saved block.
+     * Check and reservation are atomic, so parallel writers cannot both count on the last free slots.
+     * Every slot a write will need (new blocks, rewritten blocks, the changed meta blocks) must be reserved
+     * before the first of them is changed in memory. Rewrites need one as well, the old slot is only freed after.
+     * @param reserved the reservation, usually File::getReservedBlocks
+     * @param n number of slots
+     * @return true, iff n slots are reserved (on false, the reservation is unchanged)
+     */
+    bool reserveBlocks(uint32_t *reserved, uint32_t n);
+
+    /**
+     * Returns reserved log slots that are no longer needed (see reserveBlocks).
+     * @param reserved the reservation
+     * @param keep number of slots that stay reserved, an open File keeps slots for its INode and dirty cached DataBlock
+     */
+    void releaseBlocks(uint32_t *reserved, uint32_t keep);
+
+    /**
+     * Appends one hardlink to a readdir batch.
+     * @param link the hardlink
+     * @param batch the batch to append to
+     * @param withStat true to fill the stat field
+     * @return true, iff successful
+     */
+    bool appendDirEntry(const Hardlink &link, std::vector<DirEntry> &batch, bool withStat);
+
+    /**
+     * Appends the hardlinks of one DirectoryEntryList (or inlined DirectoryINode) that follow
+     * the last name returned by the cursor to a readdir batch, in name order, and advances the cursor.
+     * @param links all hardlinks of the list, in any order
+     * @param cursor the cursor, positioned at this list
+     * @param batch the batch to append to
+     * @param maxEntries maximum size of the batch
+     * @param withStat true to fill the stat fields
+     * @param complete set to true, iff no hardlinks of this list are left
+     * @return true, iff successful
+     */
+    bool appendDirEntries(std::vector<const Hardlink*> &links, ReaddirCursor &cursor, std::vector<DirEntry> &batch, std::size_t maxEntries, bool withStat, bool *complete);
+
     /**
      * Converts the given file from inlined to non-inlined state.
+     * Does nothing (but print a message) if the fs is too full, check isInlined afterwards.
      * @param file the file
      */
     void switchNonInline(File *file);
@@ -411,13 +1129,15 @@ private:
 
     /**
      * Removes n DataBlocks from the given file.
+     * The caller reserves the slots for the changed DataBlockLists and the INode (see reserveBlocks).
      * Always removes the last n DataBlocks (removes file content from the end).
      * Does not remove anything if the range is invalid
      * (n must be < #datablocks - 1, since the last DataBlock can never be removed).
      * @param file the file
      * @param n the number of DataBlocks to remove
+     * @return false, iff the changed blocks could not be saved
      */
-    void removeDataBlocks(File *file, std::size_t n);
+    bool removeDataBlocks(File *file, std::size_t n);
 };
 
 } // SDI4FS
@@ -12,6 +12,7 @@
 #include <iostream>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "DataBlockList.h"
@@ -23,19 +24,20 @@
 
 namespace SDI4FS {
 
-File::File(IDataBlockListCreator *blockListCreator, std::unique_ptr<FileINode> primary, std::list<uint32_t> *blockListIDs) : blockListCreator(blockListCreator), inode(std::move(primary)), blockLists(), numberOfDataBlocks(0) {
-    if (!inode->isInlined()) {
-        numberOfDataBlocks = ceil(inode->getInternalSize_b() / ((float) SDI4FS_MAX_BYTES_PER_DATABLOCK));
-        // copy list of DataBlockLists
-        size_t numberOfDataBlockLists = ceil(numberOfDataBlocks / ((float) SDI4FS_MAX_DATABLOCKS_PER_DATABLOCKLIST));
-        for (size_t i = 0; i < numberOfDataBlockLists; ++i) {
+File::File(IDataBlockListCreator *blockListCreator, std::unique_ptr<FileINode> primary, std::list<uint32_t> *blockListIDs) : blockListCreator(blockListCreator), inode(std::move(primary)), blockLists(), numberOfDataBlocks(0), reservedBlocks(0) {
+    if (inode->isExtentMapped()) {
+        // extents are stored in the inode, nothing to load
+        numberOfDataBlocks = inode->getExtentMap().size();
+    } else if (!inode->isInlined()) {
+        // copy list of DataBlockLists (the number of DataBlocks is counted in init, it depends on the DataBlock size of the fs)
+        for (size_t i = 0; inode->getDataBlockList(i) != 0; ++i) {
             blockListIDs->push_back(inode->getDataBlockList(i));
         }
         // copying the ids requests them to be loaded. caller will (=must) call init before using this object to complete construction
     }
 }
 
-File::File(IDataBlockListCreator *blockListCreator, std::unique_ptr<FileINode> empty) : blockListCreator(blockListCreator), inode(std::move(empty)), blockLists(), numberOfDataBlocks(0) {
+File::File(IDataBlockListCreator *blockListCreator, std::unique_ptr<FileINode> empty) : blockListCreator(blockListCreator), inode(std::move(empty)), blockLists(), numberOfDataBlocks(0), reservedBlocks(0) {
     // nothing else to do, file has size 0 and is empty
 }
 
@@ -46,6 +48,7 @@ void File::init(std::vector<std::unique_ptr<DataBlockList>> &blockLists) {
     }
     // copy to internal list
     for (auto &list : blockLists) {
+        numberOfDataBlocks += list->size();
         this->blockLists.push_back(list.release());
     }
 }
@@ -58,6 +61,18 @@ uint32_t File::getNumberOfDataBlocks() {
     return numberOfDataBlocks;
 }
 
+uint32_t File::getNumberOfDataBlockLists() {
+    return blockLists.size();
+}
+
+uint32_t File::getListConversionBlocks() {
+    if (!inode->isExtentMapped() || !inode->getExtentMap().isAlmostFull()) {
+        return 0;
+    }
+    // all lists for the current blocks, plus one if the next block starts a new list
+    return numberOfDataBlocks / SDI4FS_MAX_DATABLOCKS_PER_DATABLOCKLIST + 1;
+}
+
 std::list<Block*> File::convertToNonInline(std::unique_ptr<DataBlock> dataBlock) {
     std::list<Block*> changedBlocks;
     // sanity check
@@ -65,15 +80,10 @@ std::list<Block*> File::convertToNonInline(std::unique_ptr<DataBlock> dataBlock)
         std::cout << "fs: error - cannot convert non-inlined inode to non-inlined mode again" << std::endl;
         return changedBlocks;
     }
-    // create first DataBlockList (caller guarantees this will never return null)
-    DataBlockList *newList = blockListCreator->alloc();
-    // set first DataBlock, then save list
-    newList->pushDataBlock(dataBlock->getId());
-    inode->convertToNonInline(newList, *dataBlock.get());
-    blockLists.push_back(newList);
+    // new files are extent-mapped, the DataBlock is the first extent
+    inode->convertToExtents(*dataBlock.get());
     ++numberOfDataBlocks;
-    // caller must save inode, new list, datablock
-    changedBlocks.push_back(newList);
+    // caller must save inode, datablock
     changedBlocks.push_back(&getPrimaryINode());
     changedBlocks.push_back(dataBlock.get());
     // set cached
@@ -88,6 +98,19 @@ std::list<Block*> File::addDataBlock(std::unique_ptr<DataBlock> dataBlock) {
         std::cout << "fs: error - cannot add DataBlock to inline-mode file " << inode->getId() << std::endl;
         return changedBlocks;
     }
+    if (inode->isExtentMapped()) {
+        if (inode->getExtentMap().push(dataBlock->getId())) {
+            changedBlocks.push_back(&getPrimaryINode());
+            ++numberOfDataBlocks;
+            setCachedDataBlock(std::move(dataBlock));
+            return changedBlocks;
+        }
+        // too fragmented for the inode, continue with DataBlockLists
+        if (!convertToLists(changedBlocks)) {
+            std::cout << "fs: error - cannot switch file " << inode->getId() << " to DataBlockLists, fs is full" << std::endl;
+            return changedBlocks;
+        }
+    }
     // new DataBlockList required?
     if (numberOfDataBlocks % SDI4FS_MAX_DATABLOCKS_PER_DATABLOCKLIST == 0) {
         // alloc new list, put in inode (caller guarantees this will never return null)
@@ -115,6 +138,12 @@ std::list<Block*> File::removeDataBlock() {
         std::cout << "fs: error - cannot remove a DataBlock from inline-mode file " << inode->getId() << std::endl;
         return changedBlocks;
     }
+    if (inode->isExtentMapped()) {
+        inode->getExtentMap().pop();
+        --numberOfDataBlocks;
+        changedBlocks.push_back(&getPrimaryINode());
+        return changedBlocks;
+    }
     // remove last DataBlock first
     DataBlockList *last = blockLists[blockLists.size() - 1];
     last->popDataBlock();
@@ -134,6 +163,80 @@ std::list<Block*> File::removeDataBlock() {
     return changedBlocks;
 }
 
+std::list<Block*> File::cloneFrom(File &source) {
+    std::list<Block*> changedBlocks;
+    // sanity check
+    if (!inode->isInlined() || inode->getInternalSize_b() != 0) {
+        std::cout << "fs: error - cannot clone into non-empty file " << inode->getId() << std::endl;
+        return changedBlocks;
+    }
+    FileINode &sourceINode = source.getPrimaryINode();
+    if (sourceINode.isInlined()) {
+        // small file, copy content
+        char content[SDI4FS_MAX_BYTES_PER_INODE];
+        sourceINode.readInline(content, 0, sourceINode.getInternalSize_b());
+        inode->writeInline(content, 0, sourceINode.getInternalSize_b());
+    } else if (sourceINode.isExtentMapped()) {
+        // the extents are part of the inode
+        inode->convertToNonInline(true);
+        inode->getExtentMap() = sourceINode.getExtentMap();
+        numberOfDataBlocks = source.numberOfDataBlocks;
+    } else {
+        inode->convertToNonInline(false);
+        for (DataBlockList *sourceList : source.blockLists) {
+            // caller guarantees this will never return null
+            DataBlockList *newList = blockListCreator->alloc();
+            std::list<uint32_t> ids;
+            sourceList->blocks(ids);
+            for (uint32_t id : ids) {
+                newList->pushDataBlock(id);
+            }
+            inode->pushDataBlockList(newList->getId());
+            blockLists.push_back(newList);
+            changedBlocks.push_back(newList);
+        }
+        numberOfDataBlocks = source.numberOfDataBlocks;
+    }
+    inode->setInternalSize_b(sourceINode.getInternalSize_b());
+    changedBlocks.push_back(&getPrimaryINode());
+    return changedBlocks;
+}
+
+std::list<Block*> File::copyCachedDataBlock(uint32_t blockNo, uint32_t newID) {
+    std::list<Block*> changedBlocks;
+    // sanity check
+    if (!cachedDataBlock || getDataBlockID(blockNo) != cachedDataBlock->getId()) {
+        std::cout << "fs: error - cannot copy DataBlock " << blockNo << " of file " << inode->getId() << ", not cached" << std::endl;
+        return changedBlocks;
+    }
+    cachedDataBlock.reset(new DataBlock(newID, *cachedDataBlock.get()));
+    // the copy is dirty, it is saved like any other cached DataBlock
+    return setDataBlockID(blockNo, newID);
+}
+
+std::list<Block*> File::setDataBlockID(uint32_t blockNo, uint32_t id) {
+    std::list<Block*> changedBlocks;
+    if (inode->isInlined() || blockNo >= numberOfDataBlocks) {
+        std::cout << "fs: error - cannot replace DataBlock " << blockNo << " of file " << inode->getId() << std::endl;
+        return changedBlocks;
+    }
+    if (inode->isExtentMapped()) {
+        if (inode->getExtentMap().set(blockNo, id)) {
+            changedBlocks.push_back(&getPrimaryINode());
+            return changedBlocks;
+        }
+        // too fragmented for the inode, continue with DataBlockLists
+        if (!convertToLists(changedBlocks)) {
+            std::cout << "fs: error - cannot switch file " << inode->getId() << " to DataBlockLists, fs is full" << std::endl;
+            return changedBlocks;
+        }
+    }
+    DataBlockList *blockList = blockLists[blockNo / SDI4FS_MAX_DATABLOCKS_PER_DATABLOCKLIST];
+    blockList->setDataBlock(blockNo % SDI4FS_MAX_DATABLOCKS_PER_DATABLOCKLIST, id);
+    changedBlocks.push_back(blockList);
+    return changedBlocks;
+}
+
 uint32_t File::getDataBlockID(uint32_t blockNo) {
     if (inode->isInlined()) {
         std::cout << "fs: error - cannot retrieve a DataBlock from inline-mode file " << inode->getId() << std::endl;
@@ -142,6 +245,9 @@ uint32_t File::getDataBlockID(uint32_t blockNo) {
     if (blockNo >= numberOfDataBlocks) {
         return 0;
     }
+    if (inode->isExtentMapped()) {
+        return inode->getExtentMap().get(blockNo);
+    }
     // get list index, then ask the list
     uint32_t listNo = blockNo / SDI4FS_MAX_DATABLOCKS_PER_DATABLOCKLIST;
     DataBlockList *blockList = blockLists[listNo];
@@ -150,7 +256,9 @@ uint32_t File::getDataBlockID(uint32_t blockNo) {
 
 void File::blocks(std::list<uint32_t> &result) {
     result.push_back(inode->getId());
-    if (!inode->isInlined()) {
+    if (inode->isExtentMapped()) {
+        inode->getExtentMap().blocks(result);
+    } else if (!inode->isInlined()) {
         for (DataBlockList *list : blockLists) {
             result.push_back(list->getId());
             list->blocks(result);
@@ -195,6 +303,45 @@ bool File::writeToCachedDataBlock(const char *source, uint32_t pos, std::size_t
     return cachedDataBlock->write(source, pos, n);
 }
 
+bool File::convertToLists(std::list<Block*> &changedBlocks) {
+    std::list<uint32_t> ids;
+    inode->getExtentMap().blocks(ids);
+    // alloc all lists first, so a full fs leaves the extents untouched
+    size_t numberOfDataBlockLists = ceil(ids.size() / ((float) SDI4FS_MAX_DATABLOCKS_PER_DATABLOCKLIST));
+    std::vector<DataBlockList*> newLists;
+    for (size_t i = 0; i < numberOfDataBlockLists; ++i) {
+        DataBlockList *newList = blockListCreator->alloc();
+        if (newList == NULL) {
+            // never saved, so there is nothing to dealloc
+            for (DataBlockList *list : newLists) {
+                delete list;
+            }
+            return false;
+        }
+        newLists.push_back(newList);
+    }
+    inode->convertToLists();
+    auto iter = ids.begin();
+    for (DataBlockList *list : newLists) {
+        for (uint32_t i = 0; i < SDI4FS_MAX_DATABLOCKS_PER_DATABLOCKLIST && iter != ids.end(); ++i, ++iter) {
+            list->pushDataBlock(*iter);
+        }
+        inode->pushDataBlockList(list->getId());
+        blockLists.push_back(list);
+        changedBlocks.push_back(list);
+    }
+    changedBlocks.push_back(&getPrimaryINode());
+    return true;
+}
+
+std::mutex& File::getLock() {
+    return lock;
+}
+
+uint32_t* File::getReservedBlocks() {
+    return &reservedBlocks;
+}
+
 File::~File() {
     for (auto iter = blockLists.begin(); iter != blockLists.end(); ++iter) {
         delete *iter;
@@ -13,6 +13,7 @@
 #include <cstdint>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "DataBlockList.h"
@@ -70,7 +71,21 @@ public:
     uint32_t getNumberOfDataBlocks();
 
     /**
-     * Converts this File to non-inlined data storage mode.
+     * Returns the current number of used DataBlockLists (zero for inlined and extent-mapped files).
+     * @return the current number of used DataBlockLists
+     */
+    uint32_t getNumberOfDataBlockLists();
+
+    /**
+     * Returns the number of new DataBlockLists the next addDataBlock or setDataBlockID may create
+     * because the extents of this file are full and it switches to DataBlockLists.
+     * The caller must reserve these blocks in addition to the usual ones.
+     * @return number of DataBlockLists, usually zero
+     */
+    uint32_t getListConversionBlocks();
+
+    /**
+     * Converts this File to non-inlined, extent-mapped data storage mode.
      * Before calling this method, a new DataBlock must be allocated.
      * This method copies all currently inlined data into the given DataBlock.
      * The given DataBlock is set as the currently cached DataBlock.
@@ -84,6 +99,7 @@ public:
     /**
      * Adds a DataBlock to this file.
      * The given DataBlock is also set as cached.
+     * Extent-mapped files whose extents are full switch to DataBlockLists (see getListConversionBlocks).
      * @param dataBlock the new data block.
      * @return list of changed blocks, including the given data block
      */
@@ -96,6 +112,36 @@ public:
      */
     std::list<Block*> removeDataBlock();
 
+    /**
+     * Turns this new, empty File into a clone of the given File.
+     * Inlined content is copied. Otherwise, this File gets its own extents or DataBlockLists,
+     * which reference the same DataBlocks as the source (the caller must count these references).
+     * Afterwards, all returned blocks must be saved (this will include the primary INode).
+     * @param source the file to clone, not modified
+     * @return list of changed blocks
+     */
+    std::list<Block*> cloneFrom(File &source);
+
+    /**
+     * Replaces the cached DataBlock by a copy with a new blockID (copy-on-write of a shared DataBlock).
+     * The copy is set as cached, the DataBlockList entry is changed to the new blockID.
+     * Afterwards, all returned blocks must be saved. The copy is dirty and saved with the cached DataBlock.
+     * @param blockNo number of the cached data block, starts at zero
+     * @param newID blockID of the copy
+     * @return list of changed blocks, empty if blockNo is not cached
+     */
+    std::list<Block*> copyCachedDataBlock(uint32_t blockNo, uint32_t newID);
+
+    /**
+     * Replaces the blockID of the nth DataBlock of this file.
+     * Extent-mapped files whose extents are full switch to DataBlockLists (see getListConversionBlocks).
+     * Afterwards, all returned blocks must be saved.
+     * @param blockNo number of the data block, starts at zero
+     * @param id the new blockID
+     * @return list of changed blocks, empty if blockNo is invalid
+     */
+    std::list<Block*> setDataBlockID(uint32_t blockNo, uint32_t id);
+
     /**
      * Gets the ID of the nths DataBlock of this file.
      * @param blockNo number of the data block, starts at zero
@@ -157,8 +203,30 @@ public:
      */
     bool writeToCachedDataBlock(const char *source, uint32_t pos, std::size_t n);
 
+    /**
+     * Returns the lock that guards this File (INode, DataBlockLists and cached DataBlock) while it is open.
+     * Not used by File itself, the FS holds it for data I/O.
+     * @return the lock of this File
+     */
+    std::mutex& getLock();
+
+    /**
+     * Returns the number of log slots the FS reserved for this File (see FS::reserveBlocks).
+     * Only used by the FS, guarded by the lock of this File.
+     * @return pointer to the reservation counter
+     */
+    uint32_t* getReservedBlocks();
+
     virtual ~File();
 private:
+    /**
+     * Switches this extent-mapped File to DataBlockLists, which can map any number of DataBlocks.
+     * Allocates and fills one DataBlockList per SDI4FS_MAX_DATABLOCKS_PER_DATABLOCKLIST DataBlocks.
+     * @param changedBlocks the new DataBlockLists and the primary INode are added, all must be saved
+     * @return true, iff successful, false if the fs is too full (nothing is changed then)
+     */
+    bool convertToLists(std::list<Block*> &changedBlocks);
+
     /**
      * Callback to main impl, used to create new DataBlockLists, if required.
      */
@@ -171,7 +239,7 @@ private:
     std::unique_ptr<FileINode> inode;
 
     /**
-     * List of currently used DataBlockLists.
+     * List of currently used DataBlockLists (empty for extent-mapped files).
      */
     std::vector<DataBlockList*> blockLists;
 
@@ -188,6 +256,16 @@ private:
      */
     std::unique_ptr<DataBlock> cachedDataBlock;
 
+    /**
+     * See getReservedBlocks().
+     */
+    uint32_t reservedBlocks;
+
+    /**
+     * See getLock().
+     */
+    std::mutex lock;
+
 };
 
 } // SDI4FS
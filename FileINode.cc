@@ -8,7 +8,6 @@
 #include "FileINode.h"
 #include "INode.h"
 
-#include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <iostream>
@@ -21,7 +20,7 @@
 
 namespace SDI4FS {
 
-FileINode::FileINode(STREAM &input) : INode(input), entries() {
+FileINode::FileINode(STREAM &input) : INode(input), entries(), extents() {
     // verify INode type
     if (getType() != SDI4FS_INODE_TYPE_REGULARFILE) {
         std::cout << "fs: fatal error - inconsistency - reading FileINode from INode of different type: " << getType() << std::endl;
@@ -30,6 +29,9 @@ FileINode::FileINode(STREAM &input) : INode(input), entries() {
     if (isInlined()) {
         // read stored content
         readN(input, &data[0], getInternalSize_b());
+    } else if (isExtentMapped()) {
+        // read extents of DataBlocks
+        extents.read(input);
     } else {
         // read stored ids of DataBlockLists
         for (int i = 0; i < SDI4FS_MAX_DATABLOCKLISTS_PER_FILE; ++i) {
@@ -45,13 +47,28 @@ FileINode::FileINode(STREAM &input) : INode(input), entries() {
     }
 }
 
-FileINode::FileINode(uint32_t id) : INode(id, SDI4FS_INODE_TYPE_REGULARFILE), entries() {
+FileINode::FileINode(uint32_t id) : INode(id, SDI4FS_INODE_TYPE_REGULARFILE), entries(), extents() {
 }
 
-void FileINode::convertToNonInline(DataBlockList *blockList, DataBlock &dataBlock) {
-    pushDataBlockList(blockList->getId());
+void FileINode::convertToExtents(DataBlock &dataBlock) {
+    extents.push(dataBlock.getId());
     dataBlock.write((char*) &data[0], 0, getInternalSize_b());
     setInlined(false);
+    setExtentMapped(true);
+}
+
+void FileINode::convertToLists() {
+    extents.clear();
+    setExtentMapped(false);
+}
+
+ExtentMap& FileINode::getExtentMap() {
+    return extents;
+}
+
+void FileINode::convertToNonInline(bool extentMapped) {
+    setInlined(false);
+    setExtentMapped(extentMapped);
 }
 
 bool FileINode::pushDataBlockList(uint32_t id) {
@@ -106,17 +123,6 @@ bool FileINode::writeInline(const char *source, uint32_t pos, std::size_t n) {
     return true;
 }
 
-uint32_t FileINode::getUserVisibleSize_b() {
-    if (isInlined()) {
-        return SDI4FS_BLOCK_SIZE;
-    } else {
-        size_t numberOfDataBlockLists = entries.size();
-        size_t numberOfDataBlocks = ceil(getInternalSize_b() / ((float) SDI4FS_MAX_BYTES_PER_DATABLOCK));
-        // 1 FileINode + #DataBlockLists + #DataBlocks
-        return ((1 + numberOfDataBlockLists + numberOfDataBlocks) * SDI4FS_BLOCK_SIZE);
-    }
-}
-
 void FileINode::setInternalSize_b(uint32_t size_b) {
     // verify range
     if (size_b <= SDI4FS_MAX_FILE_SIZE) {
@@ -131,6 +137,9 @@ void FileINode::save(STREAM &output) {
     if (isInlined()) {
         // write content
         writeN(output, &data[0], getInternalSize_b());
+    } else if (isExtentMapped()) {
+        // write extents
+        extents.save(output);
     } else {
         // write entries
         for (auto iter = entries.begin(); iter != entries.end(); ++iter) {
@@ -16,6 +16,7 @@
 
 #include "DataBlock.h"
 #include "DataBlockList.h"
+#include "ExtentMap.h"
 #include "StreamSelectorHeader.inc"
 #include "Constants.inc"
 
@@ -41,13 +42,32 @@ public:
     FileINode(uint32_t id);
 
     /**
-     * Converts this FileINode to non-inlined form.
+     * Converts this FileINode to non-inlined, extent-mapped form.
      * Irreversible, cannot be done twice.
-     * Copies all inline data to the given DataBlock
-     * @param blockList DataBlockList
+     * Copies all inline data to the given DataBlock, which becomes the first mapped DataBlock.
      * @param dataBlock DataBlock that will hold the data in the future
      */
-    void convertToNonInline(DataBlockList *blockList, DataBlock &dataBlock);
+    void convertToExtents(DataBlock &dataBlock);
+
+    /**
+     * Switches this extent-mapped FileINode to DataBlockLists.
+     * Drops all extents, the caller must push the DataBlockLists afterwards.
+     */
+    void convertToLists();
+
+    /**
+     * Returns the extents of this FileINode (extent-mapped mode only).
+     * @return the extents
+     */
+    ExtentMap& getExtentMap();
+
+    /**
+     * Converts this empty FileINode to non-inlined form without copying any data.
+     * Used for clones, which reference the DataBlocks of another file.
+     * The caller must push the DataBlockLists (or extents) and set the size afterwards.
+     * @param extentMapped true for extent-mapped form
+     */
+    void convertToNonInline(bool extentMapped);
 
     /**
      * Adds the given blockID to this FileINode (non-inlined mode only).
@@ -90,7 +110,6 @@ public:
      */
     bool writeInline(const char *source, uint32_t pos, std::size_t n);
 
-    virtual uint32_t getUserVisibleSize_b();
     virtual void setInternalSize_b(uint32_t size_b);
     virtual void save(STREAM &output);
 
@@ -101,6 +120,11 @@ private:
      */
     std::vector<uint32_t> entries;
 
+    /**
+     * Non-Inlined, extent-mapped content (blockIDs of DataBlocks)
+     */
+    ExtentMap extents;
+
     /**
      * Inlined content (raw data)
      */
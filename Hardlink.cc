@@ -8,6 +8,7 @@
 #include "Hardlink.h"
 
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <string>
 
@@ -15,22 +16,36 @@
 
 namespace SDI4FS {
 
-Hardlink::Hardlink(const std::string linkName, uint32_t targetINodeBlockID) :
-linkName(linkName), targetINodeBlockID(targetINodeBlockID) {
-    if (linkName.empty() || linkName.size() >= SDI4FS_MAX_LINK_NAME_LENGTH) {
-        std::cout << "fs: error - hardlink name exceeds limits, min 1, max " << (SDI4FS_MAX_LINK_NAME_LENGTH - 1) << ", got " << linkName.size() << std::endl;
-    }
+Hardlink::Hardlink() : targetINodeBlockID(0) {
+    memset(linkName, 0, SDI4FS_MAX_LINK_NAME_LENGTH);
 }
 
-Hardlink::~Hardlink() {
+Hardlink::Hardlink(const PathView &linkName, uint32_t targetINodeBlockID) :
+targetINodeBlockID(targetINodeBlockID) {
+    std::size_t length = linkName.size();
+    if (linkName.empty() || length >= SDI4FS_MAX_LINK_NAME_LENGTH) {
+        std::cout << "fs: error - hardlink name exceeds limits, min 1, max " << (SDI4FS_MAX_LINK_NAME_LENGTH - 1) << ", got " << length << std::endl;
+        // better save than sorry
+        if (length >= SDI4FS_MAX_LINK_NAME_LENGTH) {
+            length = SDI4FS_MAX_LINK_NAME_LENGTH - 1;
+        }
+    }
+    memset(this->linkName, 0, SDI4FS_MAX_LINK_NAME_LENGTH);
+    memcpy(this->linkName, linkName.data(), length);
 }
 
-uint32_t Hardlink::getTarget() {
+uint32_t Hardlink::getTarget() const {
     return targetINodeBlockID;
 }
 
-const std::string Hardlink::getLinkName() {
-    return linkName;
+PathView Hardlink::getLinkName() const {
+    return PathView(linkName, strnlen(linkName, SDI4FS_MAX_LINK_NAME_LENGTH));
+}
+
+void Hardlink::sanitize() {
+    linkName[SDI4FS_MAX_LINK_NAME_LENGTH - 1] = 0;
+    std::size_t length = strlen(linkName);
+    memset(&linkName[length], 0, SDI4FS_MAX_LINK_NAME_LENGTH - length);
 }
 
 } // SDI4FS
@@ -12,46 +12,64 @@
 #include <string>
 
 #include "Constants.inc"
+#include "PathUtils.inc"
 
 namespace SDI4FS {
 
 /**
  * Represents a Hardlink (only holds the data).
+ * The in-memory layout is identical to the on-disk layout (32 bytes, see sdi4fs_spec),
+ * so Hardlinks can be stored in flat arrays and read/written without conversion.
+ * The name is always NUL-padded to the full SDI4FS_MAX_LINK_NAME_LENGTH bytes.
  */
 class Hardlink {
 public:
+    /**
+     * Creates an empty Hardlink (target zero, empty name), marks unused slots.
+     */
+    Hardlink();
+
     /**
      * Creates a new Hardlink with the given parameters.
      * @param linkName the link name, max 27 chars (+\0)
      * @param targetINodeBlockID the link target INode (blockID)
      */
-    Hardlink(const std::string linkName, uint32_t targetINodeBlockID);
+    Hardlink(const PathView &linkName, uint32_t targetINodeBlockID);
 
     /**
      * Returns the target this hardlink points to (blockID of an INode).
      * @return link target
      */
-    uint32_t getTarget();
+    uint32_t getTarget() const;
 
     /**
      * Returns the link name of this hardlink.
+     * The returned view points into this object.
      * @returns the link name
      */
-    const std::string getLinkName();
+    PathView getLinkName() const;
 
-    virtual ~Hardlink();
-private:
     /**
-     * The name of this link.
-     * 27 chars max (+ \0).
+     * Repairs a Hardlink read from disk:
+     * Enforces the terminating \0 and clears everything after the first \0 (padding).
      */
-    const std::string linkName;
+    void sanitize();
+
+private:
     /**
      * Link target INode (its blockID).
      */
-    const uint32_t targetINodeBlockID;
+    uint32_t targetINodeBlockID;
+
+    /**
+     * The name of this link.
+     * 27 chars max (+ \0), NUL-padded.
+     */
+    char linkName[SDI4FS_MAX_LINK_NAME_LENGTH];
 };
 
+static_assert(sizeof (Hardlink) == SDI4FS_HARDLINK_SIZE, "in-memory Hardlink must match on-disk layout");
+
 } // SDI4FS
 
 #endif	// SDI4FS_HARDLINK_H
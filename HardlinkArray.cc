@@ -0,0 +1,104 @@
+/*
+ * File:   HardlinkArray.cpp
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 10:12 AM
+ */
+
+#include "HardlinkArray.h"
+
+#include <cstdint>
+#include <list>
+#include <string>
+
+#include "Constants.inc"
+#include "HardlinkSearch.h"
+#include "StreamUtils.inc"
+
+namespace SDI4FS {
+
+HardlinkArray::HardlinkArray() : entries(), count(0) {
+    // all slots are zeroed by the Hardlink default constructor
+}
+
+void HardlinkArray::read(STREAM &input) {
+    // read all slots at once
+    readN(input, &entries[0], sizeof (entries));
+    // pack used entries to the front (gaps are allowed on disk)
+    count = 0;
+    for (uint32_t i = 0; i < SDI4FS_MAX_LINKS_PER_DIRENTRYLIST; ++i) {
+        if (entries[i].getTarget() == 0) {
+            continue;
+        }
+        entries[i].sanitize();
+        if (i != count) {
+            entries[count] = entries[i];
+        }
+        ++count;
+    }
+    // zero the rest
+    for (uint32_t i = count; i < SDI4FS_MAX_LINKS_PER_DIRENTRYLIST; ++i) {
+        entries[i] = Hardlink();
+    }
+}
+
+void HardlinkArray::save(STREAM &output) {
+    // unused slots are always zeroed, so the array can be written as-is
+    writeN(output, &entries[0], sizeof (entries));
+}
+
+bool HardlinkArray::add(const Hardlink &link) {
+    // size check
+    if (count >= SDI4FS_MAX_LINKS_PER_DIRENTRYLIST) {
+        // full
+        return false;
+    }
+    entries[count++] = link;
+    return true;
+}
+
+bool HardlinkArray::remove(const PathView &linkName) {
+    const Hardlink *link = find(linkName);
+    if (link == NULL) {
+        return false;
+    }
+    // fill the gap with the last entry, then zero the last slot
+    uint32_t index = link - &entries[0];
+    --count;
+    entries[index] = entries[count];
+    entries[count] = Hardlink();
+    return true;
+}
+
+const Hardlink* HardlinkArray::find(const PathView &linkName) const {
+    // vectorized, compares whole records
+    int32_t index = searchHardlink(&entries[0], count, linkName);
+    if (index < 0) {
+        // not found
+        return NULL;
+    }
+    return &entries[index];
+}
+
+const Hardlink& HardlinkArray::get(uint32_t index) const {
+    return entries[index];
+}
+
+uint32_t HardlinkArray::size() const {
+    return count;
+}
+
+void HardlinkArray::clear() {
+    for (uint32_t i = 0; i < count; ++i) {
+        entries[i] = Hardlink();
+    }
+    count = 0;
+}
+
+void HardlinkArray::ls(std::list<std::string> &result) const {
+    for (uint32_t i = 0; i < count; ++i) {
+        result.push_back(entries[i].getLinkName().str());
+    }
+}
+
+} // SDI4FS
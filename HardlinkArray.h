@@ -0,0 +1,112 @@
+/*
+ * File:   HardlinkArray.h
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 10:12 AM
+ */
+
+#ifndef SDI4FS_HARDLINKARRAY_H
+#define	SDI4FS_HARDLINKARRAY_H
+
+#include <cstdint>
+#include <list>
+#include <string>
+
+#include "Constants.inc"
+#include "Hardlink.h"
+#include "PathUtils.inc"
+#include "StreamSelectorHeader.inc"
+
+namespace SDI4FS {
+
+/**
+ * Flat, fixed-size array of Hardlinks, as stored in the content area of
+ * inlined DirectoryINodes and DirectoryEntryLists.
+ * Mirrors the on-disk layout (127 * 32 bytes), so reading and writing is a single copy.
+ * In memory, the used entries are always packed at the front (no gaps),
+ * all unused slots are zeroed. Order of entries is not preserved on removal.
+ */
+class HardlinkArray {
+public:
+    /**
+     * Creates an empty HardlinkArray.
+     */
+    HardlinkArray();
+
+    /**
+     * Reads SDI4FS_MAX_LINKS_PER_DIRENTRYLIST hardlinks from the stream.
+     * Gaps (target zero) are removed.
+     * The caller must call seekg beforehand.
+     * @param input the stream to read from
+     */
+    void read(STREAM &input);
+
+    /**
+     * Writes SDI4FS_MAX_LINKS_PER_DIRENTRYLIST hardlinks (unused ones zeroed) to the stream.
+     * The caller must call seekp beforehand.
+     * @param output the stream to write into
+     */
+    void save(STREAM &output);
+
+    /**
+     * Adds a copy of the given Hardlink.
+     * @param link the link
+     * @return true, if successful, false if full
+     */
+    bool add(const Hardlink &link);
+
+    /**
+     * Removes the Hardlink with the given name.
+     * @param linkName the link name
+     * @return true, iff found (and removed)
+     */
+    bool remove(const PathView &linkName);
+
+    /**
+     * Finds a Hardlink by its link name.
+     * The returned pointer is only valid until the next modification.
+     * @param linkName the link name
+     * @return the hardlink, or NULL
+     */
+    const Hardlink* find(const PathView &linkName) const;
+
+    /**
+     * Returns the Hardlink with the given index.
+     * @param index the index, must be smaller than size()
+     * @return the hardlink
+     */
+    const Hardlink& get(uint32_t index) const;
+
+    /**
+     * Returns the number of stored Hardlinks.
+     * @return the number of stored Hardlinks
+     */
+    uint32_t size() const;
+
+    /**
+     * Removes all Hardlinks.
+     */
+    void clear();
+
+    /**
+     * Fills the given list with the names of all stored hardlinks.
+     * @param result will be filled with hardlink names
+     */
+    void ls(std::list<std::string> &result) const;
+
+private:
+    /**
+     * The entries, [0, count) are used, the rest is zeroed.
+     */
+    Hardlink entries[SDI4FS_MAX_LINKS_PER_DIRENTRYLIST];
+
+    /**
+     * Number of used entries.
+     */
+    uint32_t count;
+};
+
+} // SDI4FS
+
+#endif	// SDI4FS_HARDLINKARRAY_H
+
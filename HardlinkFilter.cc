@@ -0,0 +1,55 @@
+/*
+ * File:   HardlinkFilter.cpp
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 1:05 PM
+ */
+
+#include "HardlinkFilter.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace SDI4FS {
+
+HardlinkFilter::HardlinkFilter() {
+    clear();
+}
+
+uint64_t HardlinkFilter::hash(const PathView &linkName) {
+    // 64bit FNV-1a
+    uint64_t result = 14695981039346656037ull;
+    for (std::size_t i = 0; i < linkName.size(); ++i) {
+        result ^= (uint8_t) linkName.data()[i];
+        result *= 1099511628211ull;
+    }
+    return result;
+}
+
+void HardlinkFilter::add(uint64_t nameHash) {
+    // double hashing: bit i is (h1 + i * h2)
+    uint32_t h1 = (uint32_t) nameHash;
+    uint32_t h2 = (uint32_t) (nameHash >> 32) | 1;
+    for (uint32_t i = 0; i < SDI4FS_HARDLINK_FILTER_HASHES; ++i) {
+        uint32_t bit = (h1 + i * h2) % SDI4FS_HARDLINK_FILTER_BITS;
+        bits[bit / 64] |= 1ull << (bit % 64);
+    }
+}
+
+bool HardlinkFilter::mayContain(uint64_t nameHash) const {
+    uint32_t h1 = (uint32_t) nameHash;
+    uint32_t h2 = (uint32_t) (nameHash >> 32) | 1;
+    for (uint32_t i = 0; i < SDI4FS_HARDLINK_FILTER_HASHES; ++i) {
+        uint32_t bit = (h1 + i * h2) % SDI4FS_HARDLINK_FILTER_BITS;
+        if ((bits[bit / 64] & (1ull << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void HardlinkFilter::clear() {
+    memset(bits, 0, sizeof (bits));
+}
+
+} // SDI4FS
@@ -0,0 +1,69 @@
+/*
+ * File:   HardlinkFilter.h
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 1:05 PM
+ */
+
+#ifndef SDI4FS_HARDLINKFILTER_H
+#define	SDI4FS_HARDLINKFILTER_H
+
+#include <cstdint>
+
+#include "PathUtils.inc"
+
+#define SDI4FS_HARDLINK_FILTER_BITS 1024 // 128B per filter, ~2% false positives for 127 names
+#define SDI4FS_HARDLINK_FILTER_HASHES 4 // bits set/tested per name
+
+namespace SDI4FS {
+
+/**
+ * In-memory Bloom filter over link names.
+ * Used to skip DirectoryEntryLists that certainly do not contain a name.
+ * Never stored on disk. Names cannot be removed, the filter must be rebuilt instead.
+ */
+class HardlinkFilter {
+public:
+    /**
+     * Creates an empty filter.
+     */
+    HardlinkFilter();
+
+    /**
+     * Hashes the given name for use with add() and mayContain().
+     * Callers testing several filters should hash only once.
+     * @param linkName the link name
+     * @return hash of the name
+     */
+    static uint64_t hash(const PathView &linkName);
+
+    /**
+     * Adds a name (given as hash) to this filter.
+     * @param nameHash result of hash()
+     */
+    void add(uint64_t nameHash);
+
+    /**
+     * Tests a name (given as hash).
+     * False positives are possible, false negatives are not.
+     * @param nameHash result of hash()
+     * @return false, if the name was definitely never added
+     */
+    bool mayContain(uint64_t nameHash) const;
+
+    /**
+     * Removes all names.
+     */
+    void clear();
+
+private:
+    /**
+     * The filter bits.
+     */
+    uint64_t bits[SDI4FS_HARDLINK_FILTER_BITS / 64];
+};
+
+} // SDI4FS
+
+#endif	// SDI4FS_HARDLINKFILTER_H
+
@@ -0,0 +1,124 @@
+/*
+ * File:   HardlinkSearch.cpp
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 11:40 AM
+ */
+
+#include "HardlinkSearch.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "Constants.inc"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SDI4FS_HARDLINKSEARCH_X86
+#include <immintrin.h>
+#endif
+
+namespace SDI4FS {
+
+namespace {
+
+/**
+ * Signature of all search kernels.
+ * @param records first byte of the first Hardlink record
+ * @param count number of records
+ * @param key 32 byte search key (4 ignored bytes + NUL-padded name)
+ * @return index of the first matching record, or -1
+ */
+typedef int32_t(*SearchKernel)(const uint8_t *records, uint32_t count, const uint8_t *key);
+
+// the compared bytes of a record (everything but the target id)
+#define SDI4FS_NAME_OFFSET (SDI4FS_HARDLINK_SIZE - SDI4FS_MAX_LINK_NAME_LENGTH)
+// movemask of a full match, the bits of the target id are don't-care
+#define SDI4FS_TARGET_ID_MASK ((1u << SDI4FS_NAME_OFFSET) - 1)
+
+int32_t searchScalar(const uint8_t *records, uint32_t count, const uint8_t *key) {
+    for (uint32_t i = 0; i < count; ++i) {
+        if (memcmp(&records[i * SDI4FS_HARDLINK_SIZE + SDI4FS_NAME_OFFSET], &key[SDI4FS_NAME_OFFSET], SDI4FS_MAX_LINK_NAME_LENGTH) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+#ifdef SDI4FS_HARDLINKSEARCH_X86
+
+__attribute__((target("sse2")))
+int32_t searchSSE2(const uint8_t *records, uint32_t count, const uint8_t *key) {
+    const __m128i keyLow = _mm_loadu_si128((const __m128i*) &key[0]);
+    const __m128i keyHigh = _mm_loadu_si128((const __m128i*) &key[16]);
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint8_t *record = &records[i * SDI4FS_HARDLINK_SIZE];
+        uint32_t low = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) &record[0]), keyLow));
+        uint32_t high = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) &record[16]), keyHigh));
+        if (((high << 16) | low | SDI4FS_TARGET_ID_MASK) == 0xFFFFFFFFu) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+__attribute__((target("avx2")))
+int32_t searchAVX2(const uint8_t *records, uint32_t count, const uint8_t *key) {
+    const __m256i keyVector = _mm256_loadu_si256((const __m256i*) &key[0]);
+    for (uint32_t i = 0; i < count; ++i) {
+        __m256i record = _mm256_loadu_si256((const __m256i*) &records[i * SDI4FS_HARDLINK_SIZE]);
+        uint32_t match = _mm256_movemask_epi8(_mm256_cmpeq_epi8(record, keyVector));
+        if ((match | SDI4FS_TARGET_ID_MASK) == 0xFFFFFFFFu) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+#endif // SDI4FS_HARDLINKSEARCH_X86
+
+/**
+ * The kernel for this cpu, selected on first use.
+ */
+struct KernelSelection {
+    SearchKernel kernel;
+    const char *name;
+
+    KernelSelection() : kernel(searchScalar), name("scalar") {
+#ifdef SDI4FS_HARDLINKSEARCH_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            kernel = searchAVX2;
+            name = "avx2";
+        } else if (__builtin_cpu_supports("sse2")) {
+            kernel = searchSSE2;
+            name = "sse2";
+        }
+#endif // SDI4FS_HARDLINKSEARCH_X86
+    }
+};
+
+const KernelSelection& selection() {
+    // initialized once (thread-safe since C++11)
+    static const KernelSelection selected;
+    return selected;
+}
+
+} // anonymous
+
+int32_t searchHardlink(const Hardlink *entries, uint32_t count, const PathView &linkName) {
+    // names that cannot be stored can never be found
+    if (linkName.empty() || linkName.size() >= SDI4FS_MAX_LINK_NAME_LENGTH) {
+        return -1;
+    }
+    // build key with the same layout as the records
+    uint8_t key[SDI4FS_HARDLINK_SIZE];
+    memset(key, 0, SDI4FS_HARDLINK_SIZE);
+    memcpy(&key[SDI4FS_NAME_OFFSET], linkName.data(), linkName.size());
+    return selection().kernel((const uint8_t*) entries, count, key);
+}
+
+const char* hardlinkSearchKernelName() {
+    return selection().name;
+}
+
+} // SDI4FS
@@ -0,0 +1,40 @@
+/*
+ * File:   HardlinkSearch.h
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 11:40 AM
+ */
+
+#ifndef SDI4FS_HARDLINKSEARCH_H
+#define	SDI4FS_HARDLINKSEARCH_H
+
+#include <cstdint>
+
+#include "Hardlink.h"
+#include "PathUtils.inc"
+
+namespace SDI4FS {
+
+/**
+ * Searches a packed array of Hardlinks for the given link name.
+ * Every record is compared as a whole (32 bytes, target id masked out) against a NUL-padded copy of the name.
+ * On x86, the compare uses AVX2 (1 vector compare per record) or SSE2 (2 per record),
+ * selected once at runtime depending on the cpu. All other platforms use a plain memcmp.
+ * Requires that all names in the array are NUL-padded (guaranteed by Hardlink).
+ * @param entries the first Hardlink
+ * @param count number of Hardlinks to search
+ * @param linkName the link name
+ * @return the index of the matching Hardlink, or -1
+ */
+int32_t searchHardlink(const Hardlink *entries, uint32_t count, const PathView &linkName);
+
+/**
+ * Returns the name of the search kernel selected for this cpu ("avx2", "sse2" or "scalar").
+ * @return name of the search kernel
+ */
+const char* hardlinkSearchKernelName();
+
+} // SDI4FS
+
+#endif	// SDI4FS_HARDLINKSEARCH_H
+
@@ -0,0 +1,86 @@
+/*
+ * File:   IDeviceEngine.h
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 5:40 PM
+ */
+
+#ifndef SDI4FS_IDEVICEENGINE_H
+#define	SDI4FS_IDEVICEENGINE_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SDI4FS {
+
+/**
+ * One transfer between memory and the device, see IDeviceEngine.
+ */
+struct DeviceIORequest {
+    /**
+     * Byte offset on the device.
+     */
+    uint64_t pos;
+
+    /**
+     * Memory to read into or write from, at least size_b bytes.
+     */
+    char *buf;
+
+    /**
+     * Number of bytes to transfer.
+     */
+    uint32_t size_b;
+};
+
+/**
+ * Backend that moves bytes between memory and the (linux) device file.
+ * Works on batches: all requests of one call may be in flight at the same time and are complete when the call returns.
+ * Requests of one batch must not overlap.
+ * Engines are not thread-safe, see DeviceStreamBuf for the layer that serializes and batches fs accesses.
+ */
+class IDeviceEngine {
+public:
+    /**
+     * Reads all requests.
+     * Bytes beyond the end of the device read as zero.
+     * @param requests the requests
+     * @param count number of requests
+     * @return true, iff all requests were read
+     */
+    virtual bool read(DeviceIORequest *requests, std::size_t count) = 0;
+
+    /**
+     * Writes all requests.
+     * @param requests the requests
+     * @param count number of requests
+     * @return true, iff all requests were written
+     */
+    virtual bool write(const DeviceIORequest *requests, std::size_t count) = 0;
+
+    /**
+     * Forces all written data to stable storage.
+     * @return true, iff successful
+     */
+    virtual bool flush() = 0;
+
+    /**
+     * Returns the size of the device.
+     * @return the size in bytes
+     */
+    virtual uint64_t getSize_b() = 0;
+
+    /**
+     * Returns a short name of this engine, for diagnostics.
+     * @return the name
+     */
+    virtual const char* getName() = 0;
+
+    virtual ~IDeviceEngine() {
+        // this desctructor has a body, because otherwise, gcc (linker) emits the infamous "undefined reference to vtable" error.
+    }
+};
+
+}
+
+#endif	// SDI4FS_IDEVICEENGINE_H
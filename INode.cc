@@ -21,11 +21,12 @@ INode::INode(STREAM &input) : Block::Block(input) {
     // read creationTime and size_b
     read32(input, &creationTime);
     read32(input, &size_b);
-    // read type (4 bits) + inlined (1bit)
+    // read type (4 bits) + inlined (1bit) + extentMapped (1bit)
     uint8_t typeAndInline;
     read8(input, &typeAndInline);
     type = (typeAndInline >> 4) & 0xF;
     inlined = (typeAndInline & 0x08) != 0 ? true : false;
+    extentMapped = (typeAndInline & 0x04) != 0 ? true : false;
     // jump 1 byte forward
     input.seekg(1, input.cur);
     // read linkCounter
@@ -33,7 +34,7 @@ INode::INode(STREAM &input) : Block::Block(input) {
 }
 
 INode::INode(uint32_t id, uint8_t type) : Block::Block(id),
-size_b(0), inlined(true), linkCounter(0) {
+size_b(0), inlined(true), extentMapped(false), linkCounter(0) {
     creationTime = now();
     // only 4bits on disk
     if (type > 0xF) {
@@ -65,6 +66,14 @@ void INode::setInlined(bool inlined) {
     this->inlined = inlined;
 }
 
+bool INode::isExtentMapped() {
+    return extentMapped;
+}
+
+void INode::setExtentMapped(bool extentMapped) {
+    this->extentMapped = extentMapped;
+}
+
 uint8_t INode::getType() {
     return type;
 }
@@ -76,10 +85,10 @@ uint16_t INode::getLinkCounter() {
 void INode::save(STREAM &output) {
     // call super first (*cough* anitpattern *cough*)
     Block::save(output);
-    // write creationTime, size, type, inline, link counter
+    // write creationTime, size, type, inline, extentMapped, link counter
     write32(output, creationTime);
     write32(output, size_b);
-    uint8_t typeAndInline = type << 4 | inlined << 3;
+    uint8_t typeAndInline = type << 4 | inlined << 3 | extentMapped << 2;
     write8(output, typeAndInline);
     output.seekp(1, output.cur);
     write16(output, linkCounter);
@@ -22,7 +22,7 @@
 namespace SDI4FS {
 
 /**
- * Superclass for INodes, holds common values (creation time, size, type, inline flag, link counter)
+ * Superclass for INodes, holds common values (creation time, size, type, inline and extent flags, link counter)
  */
 class INode : public Block {
 public:
@@ -55,15 +55,6 @@ public:
      */
     uint8_t getType();
 
-    /**
-     * Returns the size in bytes of this INode or its content.
-     * Exact meaning depends on type/subclass.
-     * Example: Dirs usually return the size the directory data structures use on disk,
-     * files return the number of bytes of the actual content (omitting fs overhead).
-     * @return user visible size in bytes
-     */
-    virtual uint32_t getUserVisibleSize_b() = 0;
-
     /**
      * Returns the size of the actual content of this INode in bytes.
      * @return the size of the actual content in bytes
@@ -82,6 +73,13 @@ public:
      */
     bool isInlined();
 
+    /**
+     * Returns true, iff the content of this INode is a list of extents instead of a list of blockIDs.
+     * Only used by non-inlined FileINodes.
+     * @return true, iff extent-mapped
+     */
+    bool isExtentMapped();
+
     /**
      * Returns the number of links to this INode.
      * @return the number of links to this INode
@@ -110,6 +108,12 @@ protected:
      */
     void setInlined(bool inlined);
 
+    /**
+     * Sets the extent-mapped-flag to the given value.
+     * @param extentMapped the new extent-mapped flag
+     */
+    void setExtentMapped(bool extentMapped);
+
 private:
     /**
      * UNIX-timestamp, time of INode creation.
@@ -135,6 +139,11 @@ private:
      */
     bool inlined;
 
+    /**
+     * True, iff content is a list of extents (see ExtentMap).
+     */
+    bool extentMapped;
+
     /**
      * Number of other INodes pointing to this INode.
      */
@@ -0,0 +1,84 @@
+/*
+ * File:   IOQueue.cpp
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 7:00 PM
+ */
+
+#include "IOQueue.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SDI4FS {
+
+IOQueue::IOQueue(uint32_t threads) {
+    for (uint32_t i = 0; i < threads || i == 0; ++i) {
+        std::unique_ptr<Worker> worker(new Worker());
+        worker->stop = false;
+        workers.push_back(std::move(worker));
+    }
+}
+
+IOQueue::~IOQueue() {
+    shutdown();
+}
+
+bool IOQueue::submit(uint32_t key, std::function<void()> task) {
+    Worker &worker = *workers[key % workers.size()];
+    {
+        std::lock_guard<std::mutex> guard(worker.lock);
+        if (worker.stop) {
+            return false;
+        }
+        worker.tasks.push_back(std::move(task));
+        if (!worker.thread.joinable()) {
+            // first use
+            worker.thread = std::thread(run, std::ref(worker));
+        }
+    }
+    worker.ready.notify_one();
+    return true;
+}
+
+void IOQueue::shutdown() {
+    for (auto &worker : workers) {
+        {
+            std::lock_guard<std::mutex> guard(worker->lock);
+            worker->stop = true;
+        }
+        worker->ready.notify_one();
+    }
+    for (auto &worker : workers) {
+        // never started or already joined otherwise
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+void IOQueue::run(Worker &worker) {
+    std::unique_lock<std::mutex> guard(worker.lock);
+    while (true) {
+        while (worker.tasks.empty() && !worker.stop) {
+            worker.ready.wait(guard);
+        }
+        if (worker.tasks.empty()) {
+            // stop requested and drained
+            return;
+        }
+        std::function<void()> task = std::move(worker.tasks.front());
+        worker.tasks.pop_front();
+        guard.unlock();
+        task();
+        guard.lock();
+    }
+}
+
+} // SDI4FS
@@ -0,0 +1,103 @@
+/*
+ * File:   IOQueue.h
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 7:00 PM
+ */
+
+#ifndef SDI4FS_IOQUEUE_H
+#define	SDI4FS_IOQUEUE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SDI4FS {
+
+/**
+ * Fixed set of I/O threads that run submitted tasks, the engine behind the FS async API.
+ * Each task has a key (the file handle), tasks with the same key always run on the same thread,
+ * in submission order. Tasks with different keys may run in parallel.
+ * Threads are started on first use, so users of the synchronous API never pay for them.
+ */
+class IOQueue {
+public:
+    /**
+     * Creates a new queue, no threads are started yet.
+     * @param threads number of I/O threads, at least 1
+     */
+    explicit IOQueue(uint32_t threads);
+
+    /**
+     * Calls shutdown().
+     */
+    ~IOQueue();
+
+    /**
+     * Queues a task.
+     * @param key ordering key, tasks with equal keys run one after another in submission order
+     * @param task the task
+     * @return true, iff queued (false after shutdown)
+     */
+    bool submit(uint32_t key, std::function<void()> task);
+
+    /**
+     * Runs all queued tasks to completion, then stops all threads.
+     * Later submits are rejected. Must not be called from within a task.
+     */
+    void shutdown();
+
+    IOQueue(const IOQueue&) = delete;
+    IOQueue& operator=(const IOQueue&) = delete;
+
+private:
+    /**
+     * One I/O thread and its queue.
+     */
+    struct Worker {
+        /**
+         * Guards all fields below.
+         */
+        std::mutex lock;
+
+        /**
+         * Signalled when a task was queued or stop was set.
+         */
+        std::condition_variable ready;
+
+        /**
+         * Pending tasks.
+         */
+        std::deque<std::function<void()>> tasks;
+
+        /**
+         * The thread, not joinable until the first submit.
+         */
+        std::thread thread;
+
+        /**
+         * Set by shutdown, the thread exits once tasks is empty.
+         */
+        bool stop;
+    };
+
+    /**
+     * Thread main loop.
+     * @param worker the worker this thread belongs to
+     */
+    static void run(Worker &worker);
+
+    /**
+     * The workers.
+     */
+    std::vector<std::unique_ptr<Worker>> workers;
+};
+
+}
+
+#endif	// SDI4FS_IOQUEUE_H
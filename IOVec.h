@@ -0,0 +1,48 @@
+/*
+ * File:   IOVec.h
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 7:30 PM
+ */
+
+#ifndef SDI4FS_IOVEC_H
+#define	SDI4FS_IOVEC_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SDI4FS {
+
+/**
+ * One fragment of a scattered buffer, see FS::readv and FS::writev.
+ * Same layout and meaning as the POSIX struct iovec, which is not available on all targets.
+ */
+struct IOVec {
+    /**
+     * Start of the fragment.
+     */
+    void *base;
+
+    /**
+     * Length of the fragment in bytes, may be zero.
+     */
+    std::size_t len;
+};
+
+/**
+ * Sums up the lengths of all fragments.
+ * @param iov the fragments
+ * @param iovcnt number of fragments
+ * @return total length in bytes
+ */
+inline uint64_t totalLength(const IOVec *iov, std::size_t iovcnt) {
+    uint64_t total = 0;
+    for (std::size_t i = 0; i < iovcnt; ++i) {
+        total += iov[i].len;
+    }
+    return total;
+}
+
+} // SDI4FS
+
+#endif	// SDI4FS_IOVEC_H
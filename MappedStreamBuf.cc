@@ -0,0 +1,127 @@
+/*
+ * File:   MappedStreamBuf.cpp
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 7:50 PM
+ */
+
+#include "MappedStreamBuf.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <streambuf>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace SDI4FS {
+
+MappedStreamBuf* MappedStreamBuf::open(const char *path, bool readOnly) {
+    int fd = ::open(path, readOnly ? O_RDONLY : O_RDWR);
+    if (fd < 0) {
+        std::cout << "dev: error - cannot open " << path << ": " << strerror(errno) << std::endl;
+        return NULL;
+    }
+    off_t size = lseek(fd, 0, SEEK_END);
+    if (size <= 0) {
+        std::cout << "dev: error - cannot map empty device " << path << std::endl;
+        close(fd);
+        return NULL;
+    }
+    void *map = mmap(NULL, size, readOnly ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        std::cout << "dev: error - cannot map " << path << ": " << strerror(errno) << std::endl;
+        close(fd);
+        return NULL;
+    }
+    // the fs reads blocks all over the image, kernel readahead would mostly fetch unused pages
+    madvise(map, size, MADV_RANDOM);
+    return new MappedStreamBuf(fd, static_cast<char*> (map), size, readOnly);
+}
+
+MappedStreamBuf::MappedStreamBuf(int fd, char *data, uint64_t size_b, bool readOnly) : fd(fd), data(data), size_b(size_b), pos(0), readOnly(readOnly) {
+}
+
+MappedStreamBuf::~MappedStreamBuf() {
+    munmap(data, size_b);
+    close(fd);
+}
+
+const char* MappedStreamBuf::getData() const {
+    return data;
+}
+
+uint64_t MappedStreamBuf::getSize_b() const {
+    return size_b;
+}
+
+std::streamsize MappedStreamBuf::xsgetn(char *s, std::streamsize n) {
+    if (pos >= size_b) {
+        return 0;
+    }
+    std::streamsize count = std::min<uint64_t>(n, size_b - pos);
+    memcpy(s, data + pos, count);
+    pos += count;
+    return count;
+}
+
+std::streamsize MappedStreamBuf::xsputn(const char *s, std::streamsize n) {
+    if (readOnly || pos >= size_b) {
+        // the mapping cannot grow
+        return 0;
+    }
+    std::streamsize count = std::min<uint64_t>(n, size_b - pos);
+    memcpy(data + pos, s, count);
+    pos += count;
+    return count;
+}
+
+MappedStreamBuf::int_type MappedStreamBuf::underflow() {
+    if (pos >= size_b) {
+        return traits_type::eof();
+    }
+    return traits_type::to_int_type(data[pos]);
+}
+
+MappedStreamBuf::int_type MappedStreamBuf::uflow() {
+    int_type c = underflow();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        ++pos;
+    }
+    return c;
+}
+
+MappedStreamBuf::int_type MappedStreamBuf::overflow(int_type c) {
+    if (traits_type::eq_int_type(c, traits_type::eof())) {
+        return traits_type::not_eof(c);
+    }
+    char ch = traits_type::to_char_type(c);
+    return xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+}
+
+MappedStreamBuf::pos_type MappedStreamBuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+    // get and put position are the same, which does not matter
+    off_type base = dir == std::ios_base::beg ? 0 : (dir == std::ios_base::cur ? pos : size_b);
+    if (base + off < 0) {
+        return pos_type(off_type(-1));
+    }
+    pos = base + off;
+    return pos_type(pos);
+}
+
+MappedStreamBuf::pos_type MappedStreamBuf::seekpos(pos_type pos, std::ios_base::openmode which) {
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+int MappedStreamBuf::sync() {
+    if (readOnly) {
+        return 0;
+    }
+    // written data is in the page cache already, like after flushing a std::filebuf; just start the write-back
+    return msync(data, size_b, MS_ASYNC) == 0 ? 0 : -1;
+}
+
+} // SDI4FS
@@ -0,0 +1,113 @@
+/*
+ * File:   MappedStreamBuf.h
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 7:50 PM
+ */
+
+#ifndef SDI4FS_MAPPEDSTREAMBUF_H
+#define	SDI4FS_MAPPEDSTREAMBUF_H
+
+#include <cstdint>
+#include <streambuf>
+
+namespace SDI4FS {
+
+/**
+ * std::streambuf that maps the whole device file into memory (DEV_LINUX), meant for read-mostly images.
+ * Every stream read the fs does while decoding blocks is a plain memcpy from the mapping, there are no read
+ * system calls and no second copy in a user-space cache, the kernel page cache is the only cache.
+ * Writes go to the (shared) mapping as well, so the fs still works normally, e.g. for the mount/unmount header updates.
+ * Mapped read-only, it pairs with FS read-only mounts: many processes can then share one image and its page cache.
+ * Get and put position are the same, like std::filebuf.
+ * Not thread-safe, FS serializes all device accesses.
+ */
+class MappedStreamBuf : public std::streambuf {
+public:
+    /**
+     * Maps the given device file.
+     * Caller is responsible for cleaning up the created object.
+     * @param path path of the device file
+     * @param readOnly true to open and map the file read-only (all writes fail), for FS read-only mounts
+     * @return the streambuf or NULL
+     */
+    static MappedStreamBuf* open(const char *path, bool readOnly);
+
+    /**
+     * Unmaps the device file.
+     */
+    virtual ~MappedStreamBuf();
+
+    /**
+     * Returns the start of the mapping.
+     * The pointer (and every pointer into the device derived from it) stays valid until this streambuf is destroyed,
+     * so callers may keep pointers to raw block contents instead of copying them.
+     * @return the mapped device
+     */
+    const char* getData() const;
+
+    /**
+     * Returns the size of the mapping.
+     * @return size in bytes
+     */
+    uint64_t getSize_b() const;
+
+    MappedStreamBuf(const MappedStreamBuf&) = delete;
+    MappedStreamBuf& operator=(const MappedStreamBuf&) = delete;
+
+protected:
+    virtual std::streamsize xsgetn(char *s, std::streamsize n);
+
+    virtual std::streamsize xsputn(const char *s, std::streamsize n);
+
+    virtual int_type underflow();
+
+    virtual int_type uflow();
+
+    virtual int_type overflow(int_type c);
+
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which);
+
+    virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which);
+
+    virtual int sync();
+
+private:
+    /**
+     * Creates a streambuf for an existing mapping.
+     * @param fd the device file
+     * @param data the mapping
+     * @param size_b size of the mapping
+     * @param readOnly true, iff mapped read-only
+     */
+    MappedStreamBuf(int fd, char *data, uint64_t size_b, bool readOnly);
+
+    /**
+     * The device file.
+     */
+    int fd;
+
+    /**
+     * The mapping.
+     */
+    char *data;
+
+    /**
+     * Size of the mapping in bytes.
+     */
+    uint64_t size_b;
+
+    /**
+     * Current get/put position.
+     */
+    uint64_t pos;
+
+    /**
+     * True, iff mapped read-only.
+     */
+    bool readOnly;
+};
+
+}
+
+#endif	// SDI4FS_MAPPEDSTREAMBUF_H
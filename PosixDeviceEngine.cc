@@ -0,0 +1,97 @@
+/*
+ * File:   PosixDeviceEngine.cpp
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 5:45 PM
+ */
+
+#include "PosixDeviceEngine.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+
+#include "IDeviceEngine.h"
+
+namespace SDI4FS {
+
+bool preadFully(int fd, const DeviceIORequest &request) {
+    uint32_t done = 0;
+    while (done < request.size_b) {
+        ssize_t res = pread(fd, request.buf + done, request.size_b - done, request.pos + done);
+        if (res < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cout << "dev: error - read at " << request.pos << " failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        if (res == 0) {
+            // end of device
+            memset(request.buf + done, 0, request.size_b - done);
+            return true;
+        }
+        done += res;
+    }
+    return true;
+}
+
+bool pwriteFully(int fd, const DeviceIORequest &request) {
+    uint32_t done = 0;
+    while (done < request.size_b) {
+        ssize_t res = pwrite(fd, request.buf + done, request.size_b - done, request.pos + done);
+        if (res < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cout << "dev: error - write at " << request.pos << " failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        done += res;
+    }
+    return true;
+}
+
+PosixDeviceEngine::PosixDeviceEngine(int fd) : fd(fd) {
+}
+
+PosixDeviceEngine::~PosixDeviceEngine() {
+    close(fd);
+}
+
+bool PosixDeviceEngine::read(DeviceIORequest *requests, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!preadFully(fd, requests[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PosixDeviceEngine::write(const DeviceIORequest *requests, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!pwriteFully(fd, requests[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PosixDeviceEngine::flush() {
+    return fdatasync(fd) == 0;
+}
+
+uint64_t PosixDeviceEngine::getSize_b() {
+    // works for regular files and block devices (st_size is 0 for the latter)
+    off_t size = lseek(fd, 0, SEEK_END);
+    return size < 0 ? 0 : size;
+}
+
+const char* PosixDeviceEngine::getName() {
+    return "pread/pwrite";
+}
+
+} // SDI4FS
@@ -0,0 +1,71 @@
+/*
+ * File:   PosixDeviceEngine.h
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 5:45 PM
+ */
+
+#ifndef SDI4FS_POSIXDEVICEENGINE_H
+#define	SDI4FS_POSIXDEVICEENGINE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "IDeviceEngine.h"
+
+namespace SDI4FS {
+
+/**
+ * Synchronous device engine, executes the requests of a batch one after another with pread/pwrite.
+ * Works everywhere, used as fallback if io_uring is not available.
+ */
+class PosixDeviceEngine : public IDeviceEngine {
+public:
+    /**
+     * Creates a new engine for the given file descriptor.
+     * @param fd open (read/write) file descriptor of the device, closed by the engine
+     */
+    explicit PosixDeviceEngine(int fd);
+
+    virtual ~PosixDeviceEngine();
+
+    virtual bool read(DeviceIORequest *requests, std::size_t count);
+
+    virtual bool write(const DeviceIORequest *requests, std::size_t count);
+
+    virtual bool flush();
+
+    virtual uint64_t getSize_b();
+
+    virtual const char* getName();
+
+    PosixDeviceEngine(const PosixDeviceEngine&) = delete;
+    PosixDeviceEngine& operator=(const PosixDeviceEngine&) = delete;
+
+private:
+    /**
+     * The device.
+     */
+    int fd;
+};
+
+/**
+ * Reads one request synchronously, retrying short reads. Zero-fills everything beyond the end of the device.
+ * Shared with the other engines, which use it to finish partial transfers.
+ * @param fd the device
+ * @param request the request
+ * @return true, iff successful
+ */
+bool preadFully(int fd, const DeviceIORequest &request);
+
+/**
+ * Writes one request synchronously, retrying short writes.
+ * @param fd the device
+ * @param request the request
+ * @return true, iff successful
+ */
+bool pwriteFully(int fd, const DeviceIORequest &request);
+
+}
+
+#endif	// SDI4FS_POSIXDEVICEENGINE_H
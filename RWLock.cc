@@ -0,0 +1,59 @@
+/*
+ * File:   RWLock.cpp
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 3:30 PM
+ */
+
+#include "RWLock.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace SDI4FS {
+
+RWLock::RWLock() : readers(0), waitingWriters(0), writer(false) {
+}
+
+void RWLock::lock() {
+    std::unique_lock<std::mutex> guard(mutex);
+    ++waitingWriters;
+    while (writer || readers != 0) {
+        released.wait(guard);
+    }
+    --waitingWriters;
+    writer = true;
+}
+
+void RWLock::unlock() {
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        writer = false;
+    }
+    // wake all, waiting readers and the next writer sort it out
+    released.notify_all();
+}
+
+void RWLock::lockShared() {
+    std::unique_lock<std::mutex> guard(mutex);
+    // writers first
+    while (writer || waitingWriters != 0) {
+        released.wait(guard);
+    }
+    ++readers;
+}
+
+void RWLock::unlockShared() {
+    bool last;
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        last = --readers == 0;
+    }
+    // only writers wait for readers
+    if (last) {
+        released.notify_all();
+    }
+}
+
+} // SDI4FS
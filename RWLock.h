@@ -0,0 +1,111 @@
+/*
+ * File:   RWLock.h
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 3:30 PM
+ */
+
+#ifndef SDI4FS_RWLOCK_H
+#define	SDI4FS_RWLOCK_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace SDI4FS {
+
+/**
+ * Reader/writer lock (std::shared_mutex is C++17).
+ * Any number of readers, or exactly one writer.
+ * Writers are preferred: once a writer waits, new readers block until it is done.
+ * Not recursive, neither for readers nor for writers.
+ * lock()/unlock() satisfy BasicLockable, so std::lock_guard can be used for exclusive access.
+ */
+class RWLock {
+public:
+    /**
+     * Creates an unlocked RWLock.
+     */
+    RWLock();
+
+    /**
+     * Acquires exclusive (writer) access, blocks until all readers and writers are gone.
+     */
+    void lock();
+
+    /**
+     * Releases exclusive (writer) access.
+     */
+    void unlock();
+
+    /**
+     * Acquires shared (reader) access, blocks while a writer holds or waits for the lock.
+     */
+    void lockShared();
+
+    /**
+     * Releases shared (reader) access.
+     */
+    void unlockShared();
+
+private:
+    /**
+     * Guards all fields below.
+     */
+    std::mutex mutex;
+
+    /**
+     * Signalled when the lock becomes available.
+     */
+    std::condition_variable released;
+
+    /**
+     * Number of active readers.
+     */
+    uint32_t readers;
+
+    /**
+     * Number of writers waiting for the lock.
+     */
+    uint32_t waitingWriters;
+
+    /**
+     * True, iff a writer holds the lock.
+     */
+    bool writer;
+};
+
+/**
+ * Scoped shared (reader) access to a RWLock, the counterpart of std::lock_guard.
+ */
+class SharedLockGuard {
+public:
+    /**
+     * Acquires shared access.
+     * @param lock the lock, must outlive this guard
+     */
+    explicit SharedLockGuard(RWLock &lock) : lock(lock) {
+        lock.lockShared();
+    }
+
+    /**
+     * Releases shared access.
+     */
+    ~SharedLockGuard() {
+        lock.unlockShared();
+    }
+
+    SharedLockGuard(const SharedLockGuard&) = delete;
+    SharedLockGuard& operator=(const SharedLockGuard&) = delete;
+
+private:
+    /**
+     * The guarded lock.
+     */
+    RWLock &lock;
+};
+
+} // SDI4FS
+
+#endif	// SDI4FS_RWLOCK_H
+
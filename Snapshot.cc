@@ -0,0 +1,65 @@
+/*
+ * File:   Snapshot.cpp
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 8:20 PM
+ */
+
+#include "Snapshot.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "AtomicUtils.inc"
+#include "Constants.inc"
+
+namespace SDI4FS {
+
+Snapshot::Snapshot(const uint32_t *liveBMap, uint64_t entries, uint32_t usedBlocks)
+: liveBMap(liveBMap), entries(entries), usedBlocks(usedBlocks), pages((entries + SDI4FS_SNAPSHOT_PAGE_ENTRIES - 1) / SDI4FS_SNAPSHOT_PAGE_ENTRIES) {
+}
+
+void Snapshot::preserve(uint64_t index) {
+    uint64_t page = index / SDI4FS_SNAPSHOT_PAGE_ENTRIES;
+    if (pages[page]) {
+        // copied before
+        return;
+    }
+    uint64_t start = page * SDI4FS_SNAPSHOT_PAGE_ENTRIES;
+    uint64_t count = std::min<uint64_t>(SDI4FS_SNAPSHOT_PAGE_ENTRIES, entries - start);
+    pages[page].reset(new uint32_t[SDI4FS_SNAPSHOT_PAGE_ENTRIES]);
+    for (uint64_t i = 0; i < count; ++i) {
+        pages[page][i] = loadBMapEntry(&liveBMap[start + i]);
+    }
+}
+
+uint32_t Snapshot::lookup(uint64_t index) const {
+    const std::unique_ptr<uint32_t[]> &page = pages[index / SDI4FS_SNAPSHOT_PAGE_ENTRIES];
+    if (page) {
+        return page[index % SDI4FS_SNAPSHOT_PAGE_ENTRIES];
+    }
+    return loadBMapEntry(&liveBMap[index]);
+}
+
+void Snapshot::copyTo(uint32_t *target) const {
+    for (uint64_t page = 0; page < pages.size(); ++page) {
+        uint64_t start = page * SDI4FS_SNAPSHOT_PAGE_ENTRIES;
+        uint64_t count = std::min<uint64_t>(SDI4FS_SNAPSHOT_PAGE_ENTRIES, entries - start);
+        if (pages[page]) {
+            memcpy(&target[start], pages[page].get(), count * sizeof (uint32_t));
+        } else {
+            for (uint64_t i = 0; i < count; ++i) {
+                target[start + i] = loadBMapEntry(&liveBMap[start + i]);
+            }
+        }
+    }
+}
+
+uint32_t Snapshot::getUsedBlocks() const {
+    return usedBlocks;
+}
+
+} // SDI4FS
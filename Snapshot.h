@@ -0,0 +1,88 @@
+/*
+ * File:   Snapshot.h
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 8:20 PM
+ */
+
+#ifndef SDI4FS_SNAPSHOT_H
+#define	SDI4FS_SNAPSHOT_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace SDI4FS {
+
+/**
+ * Frozen copy of the bmap, see FS::createSnapshot.
+ * Since saveBlock never overwrites a block in place, the bmap at one point in time is all that is needed to
+ * describe the whole fs at that point, as long as the gc keeps the referenced log slots.
+ * The copy is made lazily, at page granularity: creating a snapshot copies nothing, each page of the live bmap is
+ * copied into the snapshot right before the first change to it (preserve).
+ * Not thread-safe, the owning FS calls all methods with its allocLock held.
+ */
+class Snapshot {
+public:
+    /**
+     * Creates a snapshot of the given live bmap.
+     * @param liveBMap the live bmap, must outlive this snapshot
+     * @param entries number of bmap entries
+     * @param usedBlocks number of used blocks at snapshot time
+     */
+    Snapshot(const uint32_t *liveBMap, uint64_t entries, uint32_t usedBlocks);
+
+    /**
+     * Must be called before the live bmap entry at index is changed.
+     * Copies the page containing index, unless already done.
+     * @param index bmap index (block id - 1)
+     */
+    void preserve(uint64_t index);
+
+    /**
+     * Returns the log position of a block at snapshot time.
+     * @param index bmap index (block id - 1)
+     * @return log position or zero
+     */
+    uint32_t lookup(uint64_t index) const;
+
+    /**
+     * Copies the whole frozen bmap.
+     * @param target array of at least entries elements
+     */
+    void copyTo(uint32_t *target) const;
+
+    /**
+     * Returns the number of used blocks at snapshot time.
+     * @return number of used blocks
+     */
+    uint32_t getUsedBlocks() const;
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+private:
+    /**
+     * The live bmap, for pages that were not copied yet.
+     */
+    const uint32_t *liveBMap;
+
+    /**
+     * Number of bmap entries.
+     */
+    uint64_t entries;
+
+    /**
+     * Number of used blocks at snapshot time.
+     */
+    uint32_t usedBlocks;
+
+    /**
+     * Copied pages, NULL while the live page is still unchanged.
+     */
+    std::vector<std::unique_ptr<uint32_t[]>> pages;
+};
+
+} // SDI4FS
+
+#endif	// SDI4FS_SNAPSHOT_H
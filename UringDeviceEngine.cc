@@ -0,0 +1,191 @@
+/*
+ * File:   UringDeviceEngine.cpp
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 5:55 PM
+ */
+
+#include "UringDeviceEngine.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "IDeviceEngine.h"
+#include "PosixDeviceEngine.h"
+
+namespace SDI4FS {
+
+UringDeviceEngine* UringDeviceEngine::create(int fd, uint32_t queueDepth) {
+    UringDeviceEngine *engine = new UringDeviceEngine(fd);
+    if (!engine->setup(queueDepth)) {
+        // fd stays with the caller
+        engine->fd = -1;
+        delete engine;
+        return NULL;
+    }
+    return engine;
+}
+
+UringDeviceEngine::UringDeviceEngine(int fd) : fd(fd), ringFd(-1), sqRing(NULL), sqRingSize(0), cqRing(NULL), cqRingSize(0), sqes(NULL), sqEntries(0),
+sqTail(NULL), sqMask(NULL), sqArray(NULL), cqHead(NULL), cqTail(NULL), cqMask(NULL), cqes(NULL) {
+}
+
+UringDeviceEngine::~UringDeviceEngine() {
+    if (sqes != NULL) {
+        munmap(sqes, sqEntries * sizeof (io_uring_sqe));
+    }
+    if (cqRing != NULL && cqRing != sqRing) {
+        munmap(cqRing, cqRingSize);
+    }
+    if (sqRing != NULL) {
+        munmap(sqRing, sqRingSize);
+    }
+    if (ringFd >= 0) {
+        close(ringFd);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+bool UringDeviceEngine::setup(uint32_t queueDepth) {
+    io_uring_params params;
+    memset(&params, 0, sizeof (params));
+    int res = syscall(__NR_io_uring_setup, queueDepth, &params);
+    if (res < 0) {
+        return false;
+    }
+    ringFd = res;
+    sqEntries = params.sq_entries;
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof (uint32_t);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof (io_uring_cqe);
+    bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMap) {
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    }
+    void *map = mmap(NULL, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    sqRing = map;
+    if (singleMap) {
+        cqRing = sqRing;
+    } else {
+        map = mmap(NULL, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        if (map == MAP_FAILED) {
+            return false;
+        }
+        cqRing = map;
+    }
+    map = mmap(NULL, sqEntries * sizeof (io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    sqes = static_cast<io_uring_sqe*> (map);
+    char *sq = static_cast<char*> (sqRing);
+    sqTail = reinterpret_cast<uint32_t*> (sq + params.sq_off.tail);
+    sqMask = reinterpret_cast<uint32_t*> (sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<uint32_t*> (sq + params.sq_off.array);
+    char *cq = static_cast<char*> (cqRing);
+    cqHead = reinterpret_cast<uint32_t*> (cq + params.cq_off.head);
+    cqTail = reinterpret_cast<uint32_t*> (cq + params.cq_off.tail);
+    cqMask = reinterpret_cast<uint32_t*> (cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*> (cq + params.cq_off.cqes);
+    iovecs.resize(sqEntries);
+    return true;
+}
+
+bool UringDeviceEngine::submitAndWait(uint8_t opcode, const DeviceIORequest *requests, std::size_t count) {
+    bool success = true;
+    for (std::size_t chunkStart = 0; chunkStart < count; chunkStart += sqEntries) {
+        uint32_t chunkSize = std::min<std::size_t>(count - chunkStart, sqEntries);
+        // queue entries, this is the only producer, so the tail can be read without synchronization
+        uint32_t tail = *sqTail;
+        for (uint32_t i = 0; i < chunkSize; ++i) {
+            const DeviceIORequest &request = requests[chunkStart + i];
+            iovecs[i].iov_base = request.buf;
+            iovecs[i].iov_len = request.size_b;
+            uint32_t index = (tail + i) & *sqMask;
+            io_uring_sqe *sqe = &sqes[index];
+            memset(sqe, 0, sizeof (io_uring_sqe));
+            sqe->opcode = opcode;
+            sqe->fd = fd;
+            sqe->off = request.pos;
+            sqe->addr = reinterpret_cast<uint64_t> (&iovecs[i]);
+            sqe->len = 1;
+            sqe->user_data = chunkStart + i;
+            sqArray[index] = index;
+        }
+        // publish to the kernel
+        __atomic_store_n(sqTail, tail + chunkSize, __ATOMIC_RELEASE);
+        uint32_t toSubmit = chunkSize;
+        uint32_t completed = 0;
+        while (completed < chunkSize) {
+            int res = syscall(__NR_io_uring_enter, ringFd, toSubmit, chunkSize - completed, IORING_ENTER_GETEVENTS, NULL, 0);
+            if (res < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                // entries may still be in flight, the ring cannot be trusted anymore
+                std::cout << "dev: error - io_uring_enter failed: " << strerror(errno) << std::endl;
+                return false;
+            }
+            toSubmit -= res;
+            // reap completions
+            uint32_t head = *cqHead;
+            uint32_t cqTailNow = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+            for (; head != cqTailNow; ++head) {
+                io_uring_cqe *cqe = &cqes[head & *cqMask];
+                const DeviceIORequest &request = requests[cqe->user_data];
+                if (cqe->res < 0) {
+                    std::cout << "dev: error - " << (opcode == IORING_OP_READV ? "read" : "write") << " at " << request.pos << " failed: " << strerror(-cqe->res) << std::endl;
+                    success = false;
+                } else if (static_cast<uint32_t> (cqe->res) < request.size_b) {
+                    // short transfer (end of device, signal, ...), finish synchronously
+                    DeviceIORequest rest = request;
+                    rest.pos += cqe->res;
+                    rest.buf += cqe->res;
+                    rest.size_b -= cqe->res;
+                    if (!(opcode == IORING_OP_READV ? preadFully(fd, rest) : pwriteFully(fd, rest))) {
+                        success = false;
+                    }
+                }
+                ++completed;
+            }
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        }
+    }
+    return success;
+}
+
+bool UringDeviceEngine::read(DeviceIORequest *requests, std::size_t count) {
+    return submitAndWait(IORING_OP_READV, requests, count);
+}
+
+bool UringDeviceEngine::write(const DeviceIORequest *requests, std::size_t count) {
+    return submitAndWait(IORING_OP_WRITEV, requests, count);
+}
+
+bool UringDeviceEngine::flush() {
+    return fdatasync(fd) == 0;
+}
+
+uint64_t UringDeviceEngine::getSize_b() {
+    off_t size = lseek(fd, 0, SEEK_END);
+    return size < 0 ? 0 : size;
+}
+
+const char* UringDeviceEngine::getName() {
+    return "io_uring";
+}
+
+} // SDI4FS
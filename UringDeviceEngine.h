@@ -0,0 +1,142 @@
+/*
+ * File:   UringDeviceEngine.h
+ * Author: agent <agent@local>
+ *
+ * Created on October 18, 2026, 5:55 PM
+ */
+
+#ifndef SDI4FS_URINGDEVICEENGINE_H
+#define	SDI4FS_URINGDEVICEENGINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+#include <vector>
+
+#include "IDeviceEngine.h"
+
+namespace SDI4FS {
+
+/**
+ * Asynchronous device engine on top of linux io_uring.
+ * All requests of a batch are queued at once and submitted with a single system call,
+ * so a batch of n blocks costs one kernel transition instead of n and the device sees the whole queue.
+ * Talks to the kernel through the raw system calls (no liburing dependency).
+ */
+class UringDeviceEngine : public IDeviceEngine {
+public:
+    /**
+     * Sets up an io_uring instance for the given file descriptor.
+     * Returns NULL if io_uring is not available (old kernel, seccomp, ...), the caller then still owns fd
+     * and should fall back to PosixDeviceEngine.
+     * Caller is responsible for cleaning up the created object.
+     * @param fd open (read/write) file descriptor of the device, closed by the engine
+     * @param queueDepth maximum number of requests in flight, larger batches are split
+     * @return the engine or NULL
+     */
+    static UringDeviceEngine* create(int fd, uint32_t queueDepth);
+
+    virtual ~UringDeviceEngine();
+
+    virtual bool read(DeviceIORequest *requests, std::size_t count);
+
+    virtual bool write(const DeviceIORequest *requests, std::size_t count);
+
+    virtual bool flush();
+
+    virtual uint64_t getSize_b();
+
+    virtual const char* getName();
+
+    UringDeviceEngine(const UringDeviceEngine&) = delete;
+    UringDeviceEngine& operator=(const UringDeviceEngine&) = delete;
+
+private:
+    /**
+     * Creates an engine without a ring, see create.
+     * @param fd the device
+     */
+    explicit UringDeviceEngine(int fd);
+
+    /**
+     * Sets up and maps the ring.
+     * @param queueDepth requested number of submission queue entries
+     * @return true, iff successful
+     */
+    bool setup(uint32_t queueDepth);
+
+    /**
+     * Submits all requests (in chunks of at most sqEntries) and waits for their completion.
+     * Short transfers are finished synchronously.
+     * @param opcode IORING_OP_READV or IORING_OP_WRITEV
+     * @param requests the requests
+     * @param count number of requests
+     * @return true, iff all requests were transferred
+     */
+    bool submitAndWait(uint8_t opcode, const DeviceIORequest *requests, std::size_t count);
+
+    /**
+     * The device.
+     */
+    int fd;
+
+    /**
+     * The io_uring instance, -1 if not set up.
+     */
+    int ringFd;
+
+    /**
+     * Mapping of the submission queue ring.
+     */
+    void *sqRing;
+
+    /**
+     * Size of the submission queue ring mapping.
+     */
+    std::size_t sqRingSize;
+
+    /**
+     * Mapping of the completion queue ring, equal to sqRing if the kernel maps both at once.
+     */
+    void *cqRing;
+
+    /**
+     * Size of the completion queue ring mapping.
+     */
+    std::size_t cqRingSize;
+
+    /**
+     * Mapping of the submission queue entries.
+     */
+    io_uring_sqe *sqes;
+
+    /**
+     * Number of submission queue entries.
+     */
+    uint32_t sqEntries;
+
+    /**
+     * Pointers into the submission queue ring.
+     */
+    uint32_t *sqTail;
+    uint32_t *sqMask;
+    uint32_t *sqArray;
+
+    /**
+     * Pointers into the completion queue ring.
+     */
+    uint32_t *cqHead;
+    uint32_t *cqTail;
+    uint32_t *cqMask;
+    io_uring_cqe *cqes;
+
+    /**
+     * One iovec per submission queue entry, the kernel reads them when the entry is submitted.
+     */
+    std::vector<iovec> iovecs;
+};
+
+}
+
+#endif	// SDI4FS_URINGDEVICEENGINE_H
@@ -7,26 +7,49 @@
 
 #include <cstdlib>
 #include <cstdint>
-#include <fstream>
 #include <iostream>
+#include <memory>
 #include <sstream>
+#include <string>
 
+#include "DeviceEngine.h"
+#include "DeviceStreamBuf.h"
 #include "FS.h"
+#include "MappedStreamBuf.h"
 
 using namespace std;
 
 /*
  * Main class for developing and debugging SDI4FS on linux.
  * Creates an instance of sdi4fs that uses a normal file as background "device".
+ * With --mmap, the file is memory-mapped instead (for read-mostly images).
  */
 int main(int argc, char** argv) {
 
-    fstream iofile("dev.dat", ios::in | ios::out | ios::binary);
-
-    if (!iofile) {
-        cerr << "Error, cannot open dev.dat" << endl;
-        return 1;
+    bool mapped = argc > 1 && std::string(argv[1]) == "--mmap";
+    // declared before devbuf, which may write back into it on destruction
+    std::unique_ptr<SDI4FS::IDeviceEngine> engine;
+    std::unique_ptr<std::streambuf> devbuf;
+    if (mapped) {
+        devbuf.reset(SDI4FS::MappedStreamBuf::open("dev.dat", false));
+        if (!devbuf) {
+            cerr << "Error, cannot map dev.dat" << endl;
+            return 1;
+        }
+        cerr << "using mmap" << endl;
+    } else {
+        // io_uring if the kernel allows it, pread/pwrite otherwise
+        // O_DIRECT, so blocks are cached once (in devbuf, below) instead of in devbuf and the kernel page cache
+        engine.reset(SDI4FS::openDeviceEngine("dev.dat", SDI4FS::DeviceEngineType::AUTO, 64, true));
+        if (!engine) {
+            cerr << "Error, cannot open dev.dat" << endl;
+            return 1;
+        }
+        cerr << "using " << engine->getName() << " engine" << endl;
+        // 4 MiB cache budget, 64 KiB readahead (there is no kernel readahead with O_DIRECT)
+        devbuf.reset(new SDI4FS::DeviceStreamBuf(*engine, 1024, 16));
     }
+    iostream iofile(devbuf.get());
 
     // Open fs
     SDI4FS::FS fs(iofile);
@@ -76,7 +99,7 @@ int main(int argc, char** argv) {
     fs.umount();
 
     // done
-    iofile.close();
+    iofile.flush();
     return 0;
 }
 
@@ -7,6 +7,7 @@
 
 #include <cstdlib>
 #include <cmath>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <memory>
@@ -22,11 +23,20 @@ using namespace std;
 
 /*
  * Creates (formats) a sdi4fs filesystem.
+ * Usage: mkfs.sdi4fs [-a] target
+ *  -a: aligned DataBlocks, block headers are stored out-of-line in a summary area
  */
 int main(int argc, char** argv) {
 
+    uint32_t features = 0;
+    if (argc == 3 && strcmp(argv[1], "-a") == 0) {
+        features |= SDI4FS_FEATURE_OUT_OF_LINE_HEADERS;
+        --argc;
+        ++argv;
+    }
+
     if (argc != 2) {
-        std::cout << "please specifiy exactly one target (file)" << std::endl;
+        std::cout << "please specifiy exactly one target (file), optionally preceded by -a" << std::endl;
         return 1;
     }
 
@@ -38,7 +48,7 @@ int main(int argc, char** argv) {
         return 2;
     }
 
-    createSDI4FS(iofile, 0);
+    createSDI4FS(iofile, 0, features);
 
     std::cout << "done." << std::endl;
 